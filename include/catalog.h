@@ -0,0 +1,49 @@
+/**
+ * @file catalog.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for the catalog of events & the scheduler processing the stations of all the events
+ *        by several workers, each worker steals the events of the others when its own ones are done.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <postmajor.h>
+/* */
+#define CATALOG_INPUT_LEN           256
+#define CATALOG_RESULT_NAME_FORMAT  "%s/%06d_%s.txt"
+
+/*----------------------------------------------------------------------*
+ * Definition of the event within the catalog, it might have its own    *
+ * input seismic data in the last column of the line                    *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	int    index;                      /* the order of the event within the catalog */
+	float  latitude;
+	float  longitude;
+	float  depth;                      /* negative downward */
+	double origin_time;
+	char   input[CATALOG_INPUT_LEN];   /* empty for the shared input */
+} CATALOG_EVENT;
+
+/*----------------------------------------------------------------------*
+ * Definition of the handlers of the scheduler, the event is opened to  *
+ * a number of tasks (stations) & closed after all of them are done by  *
+ * any of the workers                                                   *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	void *(*open)( const CATALOG_EVENT *, int *, void * );
+	void  (*task)( void *, const int, const int, void * );
+	int   (*close)( void *, void * );
+} CATALOG_HANDLERS;
+
+/* */
+int  catalog_parse_line( const char *, CATALOG_EVENT * );
+int  catalog_parse( const char *, CATALOG_EVENT ** );
+int  catalog_result_path( const char *, const CATALOG_EVENT *, char *, const size_t );
+int  catalog_schedule( const CATALOG_EVENT *, const int, const int, const CATALOG_HANDLERS *, void * );
@@ -497,6 +497,7 @@ typedef struct MS3Selections
   struct MS3SelectTime *timewindows; //!< Pointer to time window list for this source ID
   struct MS3Selections *next;        //!< Pointer to next selection, NULL if the last
   uint8_t pubversion;                //!< Selected publication version, use 0 for any
+  struct MS3SelectIndex *index;      //!< INTERNAL: Compiled index of this and following selections
 } MS3Selections;
 
 extern const MS3Selections *ms3_matchselect (const MS3Selections *selections, const char *sid,
@@ -632,6 +633,7 @@ typedef struct MS3TraceID
   struct MS3TraceID
       *next[MSTRACEID_SKIPLIST_HEIGHT]; //!< Next trace ID at first pointer, NULL if the last
   uint8_t height;                       //!< Height of skip list at \a next
+  struct MS3SegIndex *segindex;         //!< INTERNAL: Sorted index of segments, for fragmented traces
 } MS3TraceID;
 
 /** @brief Container for a collection of continuous trace segment, linkable */
@@ -640,6 +642,7 @@ typedef struct MS3TraceList
   uint32_t numtraceids;     //!< Number of traces IDs in list
   struct MS3TraceID traces; //!< Head node of trace skip list, first entry at \a traces.next[0]
   uint64_t prngstate;       //!< INTERNAL: State for Pseudo RNG
+  struct LMIOMapping *mappings; //!< INTERNAL: File mappings referenced by record lists
 } MS3TraceList;
 
 /** @brief Callback functions that return time and sample rate tolerances
@@ -776,16 +779,20 @@ typedef struct LMIO
     LMIO_NULL = 0,   //!< IO handle type is undefined
     LMIO_FILE = 1,   //!< IO handle is FILE-type
     LMIO_URL = 2,    //!< IO handle is URL-type
-    LMIO_FD = 3      //!< IO handle is a provided file descriptor
+    LMIO_FD = 3,     //!< IO handle is a provided file descriptor
+    LMIO_MMAP = 4    //!< IO handle is a read-only memory mapping of a file
   } type;            //!< IO handle type
-  void *handle;      //!< Primary IO handle, either file or URL
+  void *handle;      //!< Primary IO handle, either file, URL or mapping base
   void *handle2;     //!< Secondary IO handle for URL
   int still_running; //!< Fetch status flag for URL transmissions
+  int64_t mapsize;   //!< Size of the mapping for LMIO_MMAP
+  int64_t mappos;    //!< Read position in the mapping for LMIO_MMAP
 } LMIO;
 
 /** @def LMIO_INITIALIZER
     @brief Initialializer for the internal stream handle ::LMIO */
-#define LMIO_INITIALIZER {.type = LMIO_NULL, .handle = NULL, .handle2 = NULL, .still_running = 0}
+#define LMIO_INITIALIZER                                                                           \
+  {.type = LMIO_NULL, .handle = NULL, .handle2 = NULL, .still_running = 0, .mapsize = 0, .mappos = 0}
 
 /** @brief State container for reading miniSEED records from files or URLs.
 
@@ -807,6 +814,8 @@ typedef struct MS3FileParam
   int readoffset;   //!< INTERNAL: Read offset in read buffer
   uint32_t flags;   //!< INTERNAL: Stream reading state flags
   LMIO input;       //!< INTERNAL: IO handle, file or URL
+  int fixedreclen;  //!< INTERNAL: Length of consecutive miniSEED 2 records, 0 if unknown
+  int fixedcount;   //!< INTERNAL: Count of consecutive records of \c fixedreclen
 } MS3FileParam;
 
 /** @def MS3FileParam_INITIALIZER
@@ -821,7 +830,9 @@ typedef struct MS3FileParam
    .readlength = 0,                                                                                \
    .readoffset = 0,                                                                                \
    .flags = 0,                                                                                     \
-   .input = LMIO_INITIALIZER}
+   .input = LMIO_INITIALIZER,                                                                      \
+   .fixedreclen = 0,                                                                               \
+   .fixedcount = 0}
 
 extern int ms3_readmsr (MS3Record **ppmsr, const char *mspath, uint32_t flags, int8_t verbose);
 extern int ms3_readmsr_r (MS3FileParam **ppmsfp, MS3Record **ppmsr, const char *mspath,
@@ -1600,6 +1611,9 @@ extern void *libmseed_memory_prealloc (void *ptr, size_t size, size_t *currentsi
 #define MSF_SPLITISVERSION \
   0x0800 //!< [TraceList] Use the splitversion value as version instead of record version
 #define MSF_SKIPADJACENTDUPLICATES 0x1000 //!< [TraceList] Skip adjacent duplicate records
+#define MSF_MMAPFILE 0x2000 //!< [Parsing] Memory-map local files instead of reading via stdio
+#define MSF_FIXEDRECLEN                                                                            \
+  0x4000 //!< [Parsing] Stride through fixed-length miniSEED 2 records, detect only on mismatch
 /** @} */
 
 #ifdef __cplusplus
@@ -0,0 +1,60 @@
+/**
+ * @file libpostmajor.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for the reentrant processing library of postmajor. All the options & the loading state
+ *        are kept in the context, so the stations can be processed by several contexts at the same time.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <postmajor.h>
+#include <seisdata_load.h>
+#include <trace_cache.h>
+/* */
+#define POSTMAJOR_FORMAT_LEN  16
+
+/*----------------------------------------------------------------------*
+ * Definition of the processing context, the options are only read by  *
+ * the processing & the loading context is owned by this context        *
+ *----------------------------------------------------------------------*/
+typedef struct {
+/* Options of the processing */
+	_Bool  two_stage;            /* two stage integral */
+	_Bool  vec_sum;              /* vector summation of three channels */
+	int    metrics;              /* the selected metrics, METRIC_* */
+	float  pd_warn_threshold;
+	float  pga_warn_threshold;
+	float  pga_watch_threshold;
+/* The event & the input seismic data */
+	double      origin_time;
+	char        format[POSTMAJOR_FORMAT_LEN];
+	const char *path;
+/* The loader of the input format */
+	SEISDATA_CONTEXT loader;
+	int  (*load)( SEISDATA_CONTEXT *, SNL_INFO *, const char * );
+	int  (*identify)( const SEISDATA_CONTEXT *, const SNL_INFO *, const char *, char *, const size_t );
+	void (*release)( SEISDATA_CONTEXT * );
+} POSTMAJOR_CONTEXT;
+
+/* */
+void postmajor_context_init( POSTMAJOR_CONTEXT * );
+int  postmajor_context_input( POSTMAJOR_CONTEXT *, const char *, const char * );
+void postmajor_context_event( POSTMAJOR_CONTEXT *, const double );
+void postmajor_context_release( POSTMAJOR_CONTEXT * );
+/* */
+int  postmajor_process_station( POSTMAJOR_CONTEXT *, SNL_INFO * );
+int  postmajor_load_station( POSTMAJOR_CONTEXT *, SNL_INFO * );
+int  postmajor_identify_station( const POSTMAJOR_CONTEXT *, const SNL_INFO *, char *, const size_t );
+int  postmajor_pick_station( const POSTMAJOR_CONTEXT *, SNL_INFO * );
+int  postmajor_proc_station( const POSTMAJOR_CONTEXT *, SNL_INFO *, const _Bool, float *[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] );
+int  postmajor_slice_station( const POSTMAJOR_CONTEXT *, const SNL_INFO *, SNL_INFO * );
+void postmajor_derive_leadtime( const SNL_INFO *, const float, const float, const int, const int, float *, float *, float * );
+/* */
+void postmajor_snl_init( SNL_INFO * );
+void postmajor_snl_free( SNL_INFO * );
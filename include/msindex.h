@@ -0,0 +1,72 @@
+/**
+ * @file msindex.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for the record-level index sidecar of miniSEED files.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <libmseed.h>
+/* */
+#define MSINDEX_FILE_NAME_FORMAT  "%s.idx"
+#define MSINDEX_MAGIC             "PMMSIDX"
+#define MSINDEX_VERSION           3
+
+/*----------------------------------------------------------------------*
+ * Definition of index file header, total size is 40 bytes              *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     magic[8];
+	uint32_t version;
+	uint32_t nsids;
+	uint64_t nrecords;
+	int64_t  src_size;    /* size of the indexed miniSEED file */
+	int64_t  src_mtime;   /* modification time of the indexed miniSEED file in nanoseconds */
+} MSINDEX_HEADER;
+
+/*----------------------------------------------------------------------*
+ * Definition of index SID entry, total size is 80 bytes                *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     sid[LM_SIDLEN];
+	uint32_t first;       /* index of the first record of this SID */
+	uint32_t count;       /* number of records of this SID */
+	nstime_t max_span;    /* the longest time span of the records of this SID */
+} MSINDEX_SID;
+
+/*----------------------------------------------------------------------*
+ * Definition of index record entry, total size is 32 bytes             *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	int64_t  offset;      /* byte offset of the record in the miniSEED file */
+	nstime_t starttime;   /* time of the first sample */
+	nstime_t endtime;     /* time of the last sample */
+	int32_t  reclen;
+	uint8_t  encoding;
+	uint8_t  padding[3];
+} MSINDEX_RECORD;
+
+/*----------------------------------------------------------------------*
+ * Definition of the opened index, both files are mapped into memory    *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	const char           *path;
+	const MSINDEX_HEADER *header;
+	const MSINDEX_SID    *sids;
+	const MSINDEX_RECORD *records;
+	const char           *data;
+	size_t                idx_size;
+	size_t                data_size;
+} MSINDEX;
+
+/* */
+int64_t  msindex_build( const char *, const char * );
+MSINDEX *msindex_open( const char *, const char * );
+int      msindex_fetch( MSINDEX *, const char *, const nstime_t, const nstime_t, MS3TraceList * );
+void     msindex_close( MSINDEX * );
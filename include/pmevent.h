@@ -0,0 +1,85 @@
+/**
+ * @file pmevent.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for the native event container of postmajor, all the stations' gain applied
+ *        float32 channels of one event are kept in one file with an index sorted by SNL.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+/* */
+#define PMEVENT_MAGIC           "PMEVENT1"
+#define PMEVENT_MAGIC_LEN       8
+#define PMEVENT_VERSION         1
+#define PMEVENT_CODE_LEN        8
+#define PMEVENT_NUM_CHANNEL     3
+#define PMEVENT_DATA_ALIGN      64
+#define PMEVENT_FILE_EXTENSION  ".pme"
+
+/*----------------------------------------------------------------------*
+ * Definition of the file header, it locates the station index at the  *
+ * end of the file                                                      *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     magic[PMEVENT_MAGIC_LEN];
+	uint32_t version;
+	uint32_t nstations;
+	uint64_t index_offset;   /* byte offset of the station index */
+	uint64_t file_size;
+} PMEVENT_HEADER;
+
+/*----------------------------------------------------------------------*
+ * Definition of the station entry in the index, the entries are sorted *
+ * by station, network & location. All the channels have the same       *
+ * number of samples & the data are already demeaned                    *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     sta[PMEVENT_CODE_LEN];
+	char     net[PMEVENT_CODE_LEN];
+	char     loc[PMEVENT_CODE_LEN];
+	char     chan[PMEVENT_NUM_CHANNEL][PMEVENT_CODE_LEN];
+	float    gain[PMEVENT_NUM_CHANNEL];   /* the gain had been applied to the data */
+	int32_t  npts;
+	double   starttime;
+	double   delta;
+	uint64_t offset[PMEVENT_NUM_CHANNEL]; /* byte offset of the float32 samples of each channel */
+} PMEVENT_STATION;
+
+/*----------------------------------------------------------------------*
+ * Definition of the opened container, the whole file is mapped into    *
+ * memory                                                               *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	const char            *data;
+	size_t                 size;
+	const PMEVENT_HEADER  *header;
+	const PMEVENT_STATION *stations;
+} PMEVENT;
+
+/*----------------------------------------------------------------------*
+ * Definition of the container under writing                            *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	FILE            *fp;
+	uint64_t         offset;
+	PMEVENT_STATION *stations;
+	uint32_t         nstations;
+	uint32_t         capacity;
+} PMEVENT_WRITER;
+
+/* */
+PMEVENT               *pmevent_open( const char * );
+const PMEVENT_STATION *pmevent_station_find( const PMEVENT *, const char *, const char *, const char * );
+const float           *pmevent_channel_data( const PMEVENT *, const PMEVENT_STATION *, const int );
+void                   pmevent_close( PMEVENT * );
+PMEVENT_WRITER        *pmevent_writer_create( const char * );
+int                    pmevent_writer_append( PMEVENT_WRITER *, const PMEVENT_STATION *, float * const [PMEVENT_NUM_CHANNEL] );
+int                    pmevent_writer_close( PMEVENT_WRITER * );
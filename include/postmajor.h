@@ -28,9 +28,42 @@
 #define OUTPUT_DATA_COOR_FORMAT \
 		" %11.6lf %11.6lf %8.2lf"
 /* */
+#define OUTPUT_FILE_CONF_HEADER \
+		"  CONF"
+#define OUTPUT_DATA_CONF_FORMAT \
+		" %5s"
+/* */
+#define OUTPUT_FILE_EVENT_HEADER \
+		"  EVENT"
+#define OUTPUT_DATA_EVENT_FORMAT \
+		" %6d"
+/* */
+#define OUTPUT_SWEEP_HEADER \
+		"#SNL          PGA_TH      PD_TH       PGA_LT      PGV_LT      NA_LT"
+#define OUTPUT_SWEEP_FORMAT \
+		"%s.%s.%s %11.6lf %11.6lf %11.6lf %11.6lf %11.6lf"
+/* */
 #define NUM_CHANNEL_SNL  3
 #define EV_DURATION      180
+#define EV_PRE_DURATION  60
 #define MAX_STR_SIZE     512
+#define MAX_SWEEP_THRESHOLDS 1024
+#define MAX_PROC_CONFIGS     4
+#define PWAVE_PEAK_DURATION  3
+/* The selectable metrics & the processing stages they depend on */
+#define METRIC_PGA       0x01
+#define METRIC_PGV       0x02
+#define METRIC_PGD       0x04
+#define METRIC_PA3       0x08
+#define METRIC_PV3       0x10
+#define METRIC_PD3       0x20
+#define METRIC_TC        0x40
+#define METRIC_LEADTIME  0x80
+#define METRIC_ALL       0xff
+#define METRIC_NEED_FULL (METRIC_PGA | METRIC_PGV | METRIC_PGD | METRIC_LEADTIME)
+#define METRIC_NEED_ACC  (METRIC_PGA | METRIC_PA3 | METRIC_LEADTIME)
+#define METRIC_NEED_VEL  (METRIC_PGV | METRIC_PV3 | METRIC_TC | METRIC_LEADTIME)
+#define METRIC_NEED_DISP (METRIC_PGD | METRIC_PD3 | METRIC_TC | METRIC_LEADTIME)
 /* */
 #define PI  3.141592653589793238462643383279f
 #define PI2 6.283185307179586476925286766559f
@@ -40,7 +73,7 @@
 #define DEF_PGA_WATCH_THRESHOLD 4.0f
 
 /**
- * @brief
+ * @brief The identification & location of the station, they are only read after the station list is loaded.
  *
  */
 typedef struct {
@@ -54,6 +87,13 @@ typedef struct {
 	float latitude;
 	float longitude;
 	float elevation;
+} SNL_META;
+
+/**
+ * @brief The working state of the station during the processing, i.e. the traces & the positions.
+ *
+ */
+typedef struct {
 /* */
 	int    npts;
 	int    gaps;
@@ -61,19 +101,9 @@ typedef struct {
 	float *seis[3];       /* input trace buffer */
 	double starttime;
 /* Derived from waveform */
-	int    pick_flag;
 	int    parrival_pos;
 	int    sarrival_pos;
-	double snr;
-/* */
-	float pga;
-	float pgv;
-	float pgd;
-	float pa3;
-	float pv3;
-	float pd3;
-	float tc;
-	float pd;
+	float  pd;
 /* */
 	float *sum_vel;
 	float *sum_dis;
@@ -84,10 +114,51 @@ typedef struct {
 	int pd_warn_pos;
 	int pga_warn_pos;
 	int pga_watch_pos;
+} SNL_STATE;
+
+/**
+ * @brief The result of the station, it is all that the output & the scheduling passes need.
+ *
+ */
+typedef struct {
+/* */
+	int    pick_flag;
+	double snr;
+/* */
+	float pga;
+	float pgv;
+	float pgd;
+	float pa3;
+	float pv3;
+	float pd3;
+	float tc;
 /* */
 	float na_leadtime;
 	float pga_leadtime;
 	float pgv_leadtime;
 /* */
 	float epic_dist;
+} SNL_RESULT;
+
+/**
+ * @brief The view of one station over the station table, the parts are kept in separate arrays.
+ *
+ */
+typedef struct {
+	SNL_META   *meta;
+	SNL_STATE  *state;
+	SNL_RESULT *result;
 } SNL_INFO;
+
+/**
+ * @brief The station table as a structure of arrays, the network wide passes only stream thru the array they
+ *        need & each station only writes its own slots.
+ *
+ */
+typedef struct {
+	int         nstations;
+	SNL_META   *metas;
+	SNL_STATE  *states;
+	SNL_RESULT *results;
+	SNL_INFO   *infos;      /* the views of each station */
+} SNL_TABLE;
@@ -0,0 +1,82 @@
+/**
+ * @file result_store.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for the store of per-station results, it lets the rerun only recompute the stations
+ *        whose inputs or parameters were changed.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <postmajor.h>
+/* */
+#define RESULT_STORE_MAGIC     "PMRESST"
+#define RESULT_STORE_VERSION   1
+#define RESULT_STORE_KEY_LEN   4096
+#define RESULT_STORE_CODE_LEN  8
+#define RESULT_STORE_HASH_SIZE 4096
+
+/*----------------------------------------------------------------------*
+ * Definition of the store file header                                  *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     magic[8];
+	uint32_t version;
+	uint32_t nrows;
+} RESULT_STORE_HEADER;
+
+/*----------------------------------------------------------------------*
+ * Definition of the result row of one station, the key is the hash of  *
+ * the station's input identity & the whole option set                  *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     sta[RESULT_STORE_CODE_LEN];
+	char     net[RESULT_STORE_CODE_LEN];
+	char     loc[RESULT_STORE_CODE_LEN];
+	uint64_t key;
+/* */
+	int32_t  npts;
+	int32_t  pick_flag;
+	int32_t  parrival_pos;
+	float    delta;
+	double   starttime;
+	double   snr;
+/* */
+	float    pga;
+	float    pgv;
+	float    pgd;
+	float    pa3;
+	float    pv3;
+	float    pd3;
+	float    tc;
+	float    pd;
+	float    na_leadtime;
+	float    pga_leadtime;
+	float    pgv_leadtime;
+/* */
+	uint32_t next;      /* index+1 of the next row in the same hash slot, only used in memory */
+	uint32_t padding;
+} RESULT_STORE_ROW;
+
+/*----------------------------------------------------------------------*
+ * Definition of the opened store, all the rows are kept in memory &    *
+ * indexed by SNL                                                       *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	RESULT_STORE_ROW *rows;
+	uint32_t          nrows;
+	uint32_t          capacity;
+	uint32_t          hash[RESULT_STORE_HASH_SIZE];
+} RESULT_STORE;
+
+/* */
+RESULT_STORE *result_store_open( const char * );
+uint64_t      result_store_key( const char * );
+int           result_store_fetch( RESULT_STORE *, SNL_INFO *, const uint64_t );
+int           result_store_put( RESULT_STORE *, const SNL_INFO *, const uint64_t );
+int           result_store_close( RESULT_STORE *, const char * );
@@ -10,6 +10,7 @@
  */
 #pragma once
 /* */
+#include <stddef.h>
 #include <sachead.h>
 /* */
 #define SAC_FILE_NAME_FORMAT  "%s/%s.%s.%s.%s"
@@ -17,6 +18,7 @@
 
 /* */
 int sac_file_load( const char *, struct SAChead *, float ** );
+int sac_buffer_load( const void *, const size_t, struct SAChead *, float ** );
 struct SAChead *sac_scnl_modify( struct SAChead *, const char *, const char *, const char *, const char * );
 struct SAChead *sac_az_inc_modify( struct SAChead *, const float, const float );
 const char *sac_scnl_print( struct SAChead * );
@@ -11,12 +11,46 @@
 
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
 #include <postmajor.h>
+
+/*----------------------------------------------------------------------*
+ * Definition of the loading context, it keeps the opened input & the   *
+ * event window, so each context can be used by its own thread          *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	void   *sac;             /* tar archive of the SAC files */
+	void   *ms;              /* trace list of the miniSEED */
+	void   *ms_index;        /* record index sidecar of the miniSEED */
+	void   *ms_stream;       /* blocks of the miniSEED stream */
+	void   *tank;
+	void   *pme;
+	_Bool   ms_index_switch;
+	_Bool   keep_input;      /* the input is shared by several events, the loaded records are kept */
+	int64_t window_start;    /* nanoseconds */
+	int64_t window_end;      /* nanoseconds */
+} SEISDATA_CONTEXT;
+
+/* */
+void seisdata_context_init( SEISDATA_CONTEXT * );
+/* */
+int seisdata_load_sac( SEISDATA_CONTEXT *, SNL_INFO *, const char * );
+int seisdata_load_ms( SEISDATA_CONTEXT *, SNL_INFO *, const char * );
+int seisdata_load_tank( SEISDATA_CONTEXT *, SNL_INFO *, const char * );
+int seisdata_load_sds( SEISDATA_CONTEXT *, SNL_INFO *, const char * );
+int seisdata_load_pme( SEISDATA_CONTEXT *, SNL_INFO *, const char * );
+/* */
+int seisdata_identify_sac( const SEISDATA_CONTEXT *, const SNL_INFO *, const char *, char *, const size_t );
+int seisdata_identify_sds( const SEISDATA_CONTEXT *, const SNL_INFO *, const char *, char *, const size_t );
+int seisdata_identify_file( const SEISDATA_CONTEXT *, const SNL_INFO *, const char *, char *, const size_t );
 /* */
-int seisdata_load_sac( SNL_INFO *, const char * );
-int seisdata_load_ms( SNL_INFO *, const char * );
-int seisdata_load_tank( SNL_INFO *, const char * );
+void seisdata_window_set( SEISDATA_CONTEXT *, const double, const double );
+void seisdata_ms_index_enable( SEISDATA_CONTEXT * );
+void seisdata_keep_input_enable( SEISDATA_CONTEXT * );
 /* */
-void seisdata_release_sac( void );
-void seisdata_release_ms( void );
-void seisdata_release_tank( void );
+void seisdata_release_sac( SEISDATA_CONTEXT * );
+void seisdata_release_ms( SEISDATA_CONTEXT * );
+void seisdata_release_tank( SEISDATA_CONTEXT * );
+void seisdata_release_sds( SEISDATA_CONTEXT * );
+void seisdata_release_pme( SEISDATA_CONTEXT * );
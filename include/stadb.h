@@ -0,0 +1,65 @@
+/**
+ * @file stadb.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for the binary station database compiled from the station list, it is mapped into
+ *        memory directly.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+/* */
+#define STADB_MAGIC          "PMSTADB1"
+#define STADB_MAGIC_LEN      8
+#define STADB_VERSION        2
+#define STADB_CODE_LEN       8
+#define STADB_NUM_CHANNEL    3
+#define STADB_FILE_EXTENSION ".sdb"
+
+/*----------------------------------------------------------------------*
+ * Definition of the file header, the stations are kept in the order of *
+ * the source list right after it                                       *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     magic[STADB_MAGIC_LEN];
+	uint32_t version;
+	uint32_t nstations;
+	uint64_t file_size;
+} STADB_HEADER;
+
+/*----------------------------------------------------------------------*
+ * Definition of the station entry, all the codes are null terminated   *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     sta[STADB_CODE_LEN + 1];
+	char     net[STADB_CODE_LEN + 1];
+	char     loc[STADB_CODE_LEN + 1];
+	char     chan[STADB_NUM_CHANNEL][STADB_CODE_LEN + 1];
+	char     padding[2];
+	float    gain[STADB_NUM_CHANNEL];
+	float    latitude;
+	float    longitude;
+	float    elevation;
+} STADB_STATION;
+
+/*----------------------------------------------------------------------*
+ * Definition of the opened database, the whole file is mapped into     *
+ * memory                                                               *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	const char          *data;
+	size_t               size;
+	const STADB_HEADER  *header;
+	const STADB_STATION *stations;
+} STADB;
+
+/* */
+int  stadb_open( const char *, STADB ** );
+void stadb_close( STADB * );
+int  stadb_compile( const char *, const char * );
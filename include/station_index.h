@@ -0,0 +1,47 @@
+/**
+ * @file station_index.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for the spatial index over the station list, it answers the radius & nearest queries
+ *        around any epicenter without scanning all the stations.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <postmajor.h>
+/* Lower bound of the latitude scale (km per arc minute) of coor2distf over the whole globe */
+#define STATION_INDEX_MIN_LAT_SCALE  1.843
+
+/*----------------------------------------------------------------------*
+ * Definition of the node of the implicit k-d tree, the node of range   *
+ * [lo, hi) is at the middle & it keeps the bounding box of the range   *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	float longitude;
+	float latitude;
+	float minlon;
+	float maxlon;
+	float minlat;
+	float maxlat;
+	int   snl;        /* index of the station in the station list */
+} STATION_INDEX_NODE;
+
+/*----------------------------------------------------------------------*
+ * Definition of the station index, it is independent of the event, so  *
+ * it can be built once & reused by all the events                      *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	STATION_INDEX_NODE *nodes;
+	int                 nnodes;
+} STATION_INDEX;
+
+/* */
+STATION_INDEX *station_index_build( const SNL_META *, const int );
+int            station_index_radius( const STATION_INDEX *, const double, const double, const double, int *, double * );
+int            station_index_nearest( const STATION_INDEX *, const double, const double, const int, int *, double * );
+void           station_index_free( STATION_INDEX * );
+double         coor2distf( const double, const double, const double, const double );
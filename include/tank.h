@@ -0,0 +1,65 @@
+/**
+ * @file tank.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for reading the Earthworm tank player files of TRACEBUF2 packets.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <trace_buf.h>
+/* */
+#define TANK_HASH_SIZE  4096
+
+/*----------------------------------------------------------------------*
+ * Definition of the packet entry in the index                         *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	size_t   offset;       /* byte offset of the packet in the tank */
+	double   starttime;
+	double   endtime;
+	uint32_t scnl;         /* index of the SCNL of this packet */
+	int32_t  nsamp;
+} TANK_PACKET;
+
+/*----------------------------------------------------------------------*
+ * Definition of the SCNL entry in the index, its packets are sorted    *
+ * by the start time                                                    *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     sta[TRACE2_STA_LEN];
+	char     chan[TRACE2_CHAN_LEN];
+	char     net[TRACE2_NET_LEN];
+	char     loc[TRACE2_LOC_LEN];
+	double   samprate;
+	double   earliest;
+	double   latest;
+	uint32_t first;        /* index of the first packet of this SCNL */
+	uint32_t count;        /* number of packets of this SCNL */
+	uint32_t next;         /* index+1 of the next SCNL in the same hash slot */
+} TANK_SCNL;
+
+/*----------------------------------------------------------------------*
+ * Definition of the opened tank, the whole file is mapped into memory  *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	const char  *data;
+	size_t       size;
+	TANK_SCNL   *scnls;
+	uint32_t     nscnls;
+	TANK_PACKET *packets;
+	uint32_t     npackets;
+	uint32_t     hash[TANK_HASH_SIZE];
+} TANK;
+
+/* */
+TANK            *tank_open( const char * );
+const TANK_SCNL *tank_scnl_find( const TANK *, const char *, const char *, const char *, const char * );
+int              tank_scnl_fill( const TANK *, const TANK_SCNL *, const double, float *, const int, int * );
+void             tank_close( TANK * );
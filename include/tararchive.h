@@ -0,0 +1,45 @@
+/**
+ * @file tararchive.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for reading the members of tar or tar.bz2 archive into memory.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+/* */
+#define TAR_BLOCK_SIZE    512
+#define TAR_HASH_SIZE     8192
+#define TAR_MAX_NAME      256
+
+/*----------------------------------------------------------------------*
+ * Definition of the archive member, the data is decompressed already  *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char    *name;       /* the base name of the member, without the directory */
+	char    *data;
+	size_t   size;
+	uint32_t next;       /* index+1 of the next member in the same hash slot */
+} TAR_MEMBER;
+
+/*----------------------------------------------------------------------*
+ * Definition of the archive, all the regular file members indexed by  *
+ * their base names                                                     *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	TAR_MEMBER *members;
+	uint32_t    nmembers;
+	uint32_t    hash[TAR_HASH_SIZE];
+} TAR_ARCHIVE;
+
+/* */
+TAR_ARCHIVE *tar_archive_open( const char * );
+TAR_MEMBER  *tar_member_find( TAR_ARCHIVE *, const char * );
+void         tar_member_release( TAR_MEMBER * );
+void         tar_archive_close( TAR_ARCHIVE * );
@@ -0,0 +1,44 @@
+/*
+ *   The TRACEBUF2 packet definitions, derived from the trace_buf.h of Earthworm.
+ *   Only the parts needed for reading the tank player files are kept.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/*
+ *  Define the structure for time-series data.
+ */
+#define MAX_TRACEBUF_SIZ  4096    /* max # of bytes in tracebuf message */
+
+#define TRACE2_STA_LEN    7       /* SEED: 5 chars plus terminating NULL */
+#define TRACE2_NET_LEN    9       /* SEED: 2 chars plus terminating NULL */
+#define TRACE2_CHAN_LEN   4       /* SEED: 3 chars plus terminating NULL */
+#define TRACE2_LOC_LEN    3       /* SEED: 2 chars plus terminating NULL */
+
+#define TRACE2_VERSION0   '2'     /* version[0] for TYPE_TRACEBUF2 */
+#define TRACE2_VERSION1   '0'     /* version[1] for TYPE_TRACEBUF2 */
+
+#define LOC_NULL_STRING   "--"    /* NULL string for location code field */
+
+/*
+ *  TRACE2_HEADER: The 64-byte header of the TYPE_TRACEBUF2 packet, the samples follow it.
+ *  The datatype is one of "s2", "s4", "t4", "t8" (Sun, big-endian integer & IEEE float)
+ *  or "i2", "i4", "f4", "f8" (Intel, little-endian integer & IEEE float).
+ */
+typedef struct {
+	int32_t pinno;                  /* Pin number */
+	int32_t nsamp;                  /* Number of samples in packet */
+	double  starttime;              /* time of first sample in epoch seconds (seconds since midnight 1/1/1970) */
+	double  endtime;                /* Time of last sample in epoch seconds */
+	double  samprate;               /* Sample rate; nominal */
+	char    sta[TRACE2_STA_LEN];    /* Site name (NULL-terminated) */
+	char    net[TRACE2_NET_LEN];    /* Network name (NULL-terminated) */
+	char    chan[TRACE2_CHAN_LEN];  /* Component/Channel code (NULL-terminated) */
+	char    loc[TRACE2_LOC_LEN];    /* Location code (NULL-terminated) */
+	char    version[2];             /* version field */
+	char    datatype[3];            /* Data format code (NULL-terminated) */
+	char    quality[2];             /* Data-quality field */
+	char    pad[2];                 /* padding */
+} TRACE2_HEADER;
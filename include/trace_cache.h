@@ -0,0 +1,52 @@
+/**
+ * @file trace_cache.h
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Header file for the on-disk cache of the picked & processed traces of each station.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <postmajor.h>
+/* */
+#define TRACE_CACHE_MAGIC             "PMTRCCH"
+#define TRACE_CACHE_VERSION           2
+#define TRACE_CACHE_KEY_LEN           4096
+#define TRACE_CACHE_FILE_NAME_FORMAT  "%s/%s.%s.%s.%016llx.ptc"
+
+/*----------------------------------------------------------------------*
+ * Definition of the processing stages kept in the cache               *
+ *----------------------------------------------------------------------*/
+typedef enum {
+	TRACE_CACHE_ACC,
+	TRACE_CACHE_VEL,
+	TRACE_CACHE_DISP,
+	TRACE_CACHE_NUM_STAGES
+} TRACE_CACHE_STAGES;
+
+/*----------------------------------------------------------------------*
+ * Definition of the cache file header, the whole key is also kept for  *
+ * verifying, then followed by the samples of each stage & channel      *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	char     magic[8];
+	uint32_t version;
+	int32_t  npts;
+	double   starttime;
+	double   delta;
+	double   snr;
+	int32_t  pick_flag;
+	int32_t  parrival_pos;
+	char     key[TRACE_CACHE_KEY_LEN];
+} TRACE_CACHE_HEADER;
+
+/* */
+int  trace_cache_key_build( char *, const char *, const double, const _Bool, const _Bool, const int64_t, const int64_t );
+int  trace_cache_load( const char *, const char *, const char *, SNL_INFO *, float *[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] );
+int  trace_cache_store( const char *, const char *, const char *, const SNL_INFO *, float * const [TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] );
+void trace_cache_free( float *[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] );
@@ -42,21 +42,13 @@ EVID=`printf "%s%02d%02d%02d" ${EV_YMD} $4 $5 ${_SEC}`
 EQINFO=${TMP_DIR}/eqinfo
 STALIST=${WORKING_DIR}/stalist
 RESULT=${RES_DIR}/${EVID}_res.txt
-SAC_DIR=${TMP_DIR}/${FILENAME:0:19}
 #
 echo "Start to process Eq. ${EVID}..."
-#
-echo "Moving the archived file to local..."
-cp ${FILEPATH}/${FILENAME} ${TMP_DIR}
-echo "Decompressing the archived SAC files..."
-tar -C ${TMP_DIR} -vjxf ${TMP_DIR}/${FILENAME}
-rm -f ${TMP_DIR}/${FILENAME}
 
-#
+# The SAC files are read from the archive directly, no need to extract them
 echo "$1 $2 $3 $4 $5 $6 $7 $8 $9" > ${EQINFO}
-postmajor -f SAC -n -c ${EQINFO} ${STALIST} ${SAC_DIR} > ${RESULT}
+postmajor -f SAC -n -c ${EQINFO} ${STALIST} ${FILEPATH}/${FILENAME} > ${RESULT}
 #
-rm -rf ${SAC_DIR}
 rm -f ${EQINFO}
 #
 echo "Event processing complete!!"
@@ -0,0 +1,365 @@
+/**
+ * @file catalog.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Parse the catalog of events & process the stations of all the events by several workers. The
+ *        events are dealt to the workers at first, then each worker helps the opened events with their
+ *        stations, opens its own next event or steals the last event of the busiest worker. So only a
+ *        few events are opened at the same time & no worker is idle before the last event is opened.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <math.h>
+#include <pthread.h>
+/* */
+#include <postmajor.h>
+#include <catalog.h>
+
+/*----------------------------------------------------------------------*
+ * Definition of the opened event, the tasks are claimed in order & the *
+ * event is closed by the worker finishing the last one                 *
+ *----------------------------------------------------------------------*/
+typedef struct OPENED_EVENT {
+	void                *state;
+	int                  ntasks;
+	int                  claimed;
+	int                  done;
+	struct OPENED_EVENT *next;
+} OPENED_EVENT;
+
+/*----------------------------------------------------------------------*
+ * Definition of the scheduler, the deque of each worker is the range   *
+ * [head, tail) of the event list, the owner takes the head & the thief *
+ * takes the tail                                                       *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	pthread_mutex_t         lock;
+	pthread_cond_t          changed;     /* an event was opened */
+	const CATALOG_EVENT    *events;
+	const CATALOG_HANDLERS *handlers;
+	void                   *arg;
+	int                     nworkers;
+	int                    *heads;
+	int                    *tails;
+	OPENED_EVENT           *opened;
+	int                     opening;     /* number of the events being opened */
+	int                     failed;
+} SCHEDULER;
+
+/*----------------------------------------------------------------------*
+ * Definition of the argument of each worker thread                     *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	SCHEDULER *scheduler;
+	int        worker;
+} WORKER_ARG;
+
+/* */
+static void *worker_thread( void * );
+static int   take_event( SCHEDULER *, const int );
+
+/**
+ * @brief Parse one line of the catalog, the same columns as the eq. info with an optional input seismic data.
+ *
+ * @param line
+ * @param event
+ * @return int
+ */
+int catalog_parse_line( const char *line, CATALOG_EVENT *event )
+{
+	float     year;
+	float     mon;
+	float     day;
+	float     hour;
+	float     min;
+	float     sec;
+	struct tm _otime;
+
+/* Skip the leading spaces, the empty line & the comment */
+	for ( ; *line == '\t' || *line == ' '; line++ );
+	if ( *line == '#' || *line == '\n' || *line == '\0' )
+		return -1;
+/* */
+	event->input[0] = '\0';
+	if (
+		sscanf(
+			line, "%f %f %f %f %f %f %f %f %f %255s",
+			&year, &mon, &day, &hour, &min, &sec, &event->latitude, &event->longitude, &event->depth, event->input
+		) < 9
+	) {
+		return -1;
+	}
+/* Keep the column of second to zero, then add it back after converting */
+	memset(&_otime, 0, sizeof(_otime));
+	_otime.tm_year  = (int)year - 1900;
+	_otime.tm_mon   = (int)mon - 1;
+	_otime.tm_mday  = (int)day;
+	_otime.tm_hour  = (int)hour;
+	_otime.tm_min   = (int)min;
+	_otime.tm_sec   = 0;
+	_otime.tm_isdst = 0;
+/* If we do so, we can have fraction of second */
+	event->depth        = -event->depth;
+	event->origin_time  = (double)timegm(&_otime);
+	event->origin_time += sec;
+
+	return 0;
+}
+
+/**
+ * @brief Parse all the events of the catalog file, the events are indexed in the order of the file.
+ *
+ * @param path
+ * @param events
+ * @return int
+ */
+int catalog_parse( const char *path, CATALOG_EVENT **events )
+{
+	FILE          *fp;
+	char           line[MAX_STR_SIZE] = { 0 };
+	CATALOG_EVENT *_events  = NULL;
+	int            result   = 0;
+	int            capacity = 0;
+
+/* */
+	if ( !(fp = fopen(path, "r")) ) {
+		fprintf(stderr, "ERROR! Cannot open the catalog %s!\n", path);
+		return -2;
+	}
+/* */
+	while ( fgets(line, sizeof(line) - 1, fp) ) {
+		if ( result == capacity ) {
+			CATALOG_EVENT *_new = realloc(_events, (capacity = capacity ? capacity * 2 : 256) * sizeof(CATALOG_EVENT));
+
+			if ( !_new ) {
+				fprintf(stderr, "ERROR! Out of memory for the catalog %s!\n", path);
+				free(_events);
+				fclose(fp);
+				return -2;
+			}
+			_events = _new;
+		}
+	/* */
+		if ( !catalog_parse_line( line, &_events[result] ) ) {
+			_events[result].index = result;
+			result++;
+		}
+	}
+	fclose(fp);
+/* */
+	if ( !result ) {
+		fprintf(stderr, "ERROR! There is no event in the catalog %s!\n", path);
+		free(_events);
+		return -1;
+	}
+	*events = _events;
+
+	return result;
+}
+
+/**
+ * @brief The path of the event's result within the output directory, it is named by the index & the origin
+ *        time of the event, so the finished events can be found by the rerun.
+ *
+ * @param dir
+ * @param event
+ * @param path
+ * @param size
+ * @return int
+ */
+int catalog_result_path( const char *dir, const CATALOG_EVENT *event, char *path, const size_t size )
+{
+	char      otime[32];
+	time_t    _otime = (time_t)floor(event->origin_time);
+	struct tm tm;
+
+/* */
+	if ( !gmtime_r(&_otime, &tm) || !strftime(otime, sizeof(otime), "%Y%m%d_%H%M%S", &tm) )
+		return -1;
+
+	return snprintf(path, size, CATALOG_RESULT_NAME_FORMAT, dir, event->index, otime) < (int)size ? 0 : -1;
+}
+
+/**
+ * @brief Process all the events by the workers, the calling thread is also one of them. The number of
+ *        events failed to be opened or closed is returned.
+ *
+ * @param events
+ * @param nevents
+ * @param nworkers
+ * @param handlers
+ * @param arg
+ * @return int
+ */
+int catalog_schedule( const CATALOG_EVENT *events, const int nevents, const int nworkers, const CATALOG_HANDLERS *handlers, void *arg )
+{
+	SCHEDULER   scheduler;
+	pthread_t  *tids  = NULL;
+	WORKER_ARG *args  = NULL;
+	int         count = 1;
+
+/* */
+	memset(&scheduler, 0, sizeof(scheduler));
+	scheduler.events   = events;
+	scheduler.handlers = handlers;
+	scheduler.arg      = arg;
+	scheduler.nworkers = nworkers > 0 ? nworkers : 1;
+	if (
+		!(scheduler.heads = (int *)malloc(scheduler.nworkers * sizeof(int))) ||
+		!(scheduler.tails = (int *)malloc(scheduler.nworkers * sizeof(int))) ||
+		!(tids = (pthread_t *)malloc(scheduler.nworkers * sizeof(pthread_t))) ||
+		!(args = (WORKER_ARG *)malloc(scheduler.nworkers * sizeof(WORKER_ARG)))
+	) {
+		fprintf(stderr, "ERROR! Out of memory for the scheduler!\n");
+		free(scheduler.heads);
+		free(scheduler.tails);
+		free(tids);
+		return nevents;
+	}
+	pthread_mutex_init(&scheduler.lock, NULL);
+	pthread_cond_init(&scheduler.changed, NULL);
+/* Deal the events to the workers in contiguous blocks */
+	for ( register int i = 0; i < scheduler.nworkers; i++ ) {
+		scheduler.heads[i] = (int)((long)nevents * i / scheduler.nworkers);
+		scheduler.tails[i] = (int)((long)nevents * (i + 1) / scheduler.nworkers);
+		args[i].scheduler  = &scheduler;
+		args[i].worker     = i;
+	}
+/* The events of the worker failed to be created will be stolen by the others */
+	for ( ; count < scheduler.nworkers; count++ ) {
+		if ( pthread_create(&tids[count], NULL, worker_thread, &args[count]) ) {
+			fprintf(stderr, "WARNING! Cannot create the worker thread, only %d workers are used!\n", count);
+			break;
+		}
+	}
+	worker_thread( &args[0] );
+	for ( register int i = 1; i < count; i++ )
+		pthread_join(tids[i], NULL);
+/* */
+	pthread_mutex_destroy(&scheduler.lock);
+	pthread_cond_destroy(&scheduler.changed);
+	free(scheduler.heads);
+	free(scheduler.tails);
+	free(tids);
+	free(args);
+
+	return scheduler.failed;
+}
+
+/**
+ * @brief The worker helps the opened events first, then opens a new event from its own deque or the others.
+ *
+ * @param arg
+ * @return void*
+ */
+static void *worker_thread( void *arg )
+{
+	SCHEDULER              *scheduler = ((WORKER_ARG *)arg)->scheduler;
+	const int               worker    = ((WORKER_ARG *)arg)->worker;
+	const CATALOG_HANDLERS *handlers  = scheduler->handlers;
+	OPENED_EVENT           *opened    = NULL;
+	OPENED_EVENT          **prev      = NULL;
+	int                     task      = 0;
+	int                     ntasks    = 0;
+	int                     event     = 0;
+	int                     failed    = 0;
+	void                   *state     = NULL;
+
+/* */
+	pthread_mutex_lock(&scheduler->lock);
+	while ( true ) {
+	/* Claim the next task of the earliest opened event */
+		for ( opened = scheduler->opened; opened && opened->claimed == opened->ntasks; opened = opened->next );
+		if ( opened ) {
+			task = opened->claimed++;
+			pthread_mutex_unlock(&scheduler->lock);
+			handlers->task( opened->state, task, worker, scheduler->arg );
+			pthread_mutex_lock(&scheduler->lock);
+		/* The last one closes the event */
+			if ( ++opened->done == opened->ntasks ) {
+				for ( prev = &scheduler->opened; *prev != opened; prev = &(*prev)->next );
+				*prev = opened->next;
+				pthread_mutex_unlock(&scheduler->lock);
+				failed = handlers->close( opened->state, scheduler->arg ) < 0;
+				free(opened);
+				pthread_mutex_lock(&scheduler->lock);
+				scheduler->failed += failed;
+			}
+			continue;
+		}
+	/* Nothing to help, open a new event, or wait for the events being opened by the others */
+		if ( (event = take_event( scheduler, worker )) < 0 ) {
+			if ( !scheduler->opening )
+				break;
+			pthread_cond_wait(&scheduler->changed, &scheduler->lock);
+			continue;
+		}
+		scheduler->opening++;
+		pthread_mutex_unlock(&scheduler->lock);
+	/* */
+		ntasks = 0;
+		failed = 0;
+		opened = NULL;
+		if ( !(state = handlers->open( &scheduler->events[event], &ntasks, scheduler->arg )) ) {
+			failed = 1;
+		}
+		else if ( !ntasks ) {
+			failed = handlers->close( state, scheduler->arg ) < 0;
+		}
+		else if ( !(opened = (OPENED_EVENT *)calloc(1, sizeof(OPENED_EVENT))) ) {
+			fprintf(stderr, "ERROR! Out of memory for the scheduler!\n");
+			handlers->close( state, scheduler->arg );
+			failed = 1;
+		}
+	/* Append to the opened events, the earlier ones are helped first */
+		pthread_mutex_lock(&scheduler->lock);
+		if ( opened ) {
+			opened->state  = state;
+			opened->ntasks = ntasks;
+			for ( prev = &scheduler->opened; *prev; prev = &(*prev)->next );
+			*prev = opened;
+		}
+		scheduler->failed += failed;
+		scheduler->opening--;
+		pthread_cond_broadcast(&scheduler->changed);
+	}
+	pthread_mutex_unlock(&scheduler->lock);
+
+	return NULL;
+}
+
+/**
+ * @brief Take the head of the worker's own deque, or steal the tail of the worker with the most events left.
+ *        It should be called with the lock held.
+ *
+ * @param scheduler
+ * @param worker
+ * @return int
+ */
+static int take_event( SCHEDULER *scheduler, const int worker )
+{
+	int victim = -1;
+
+/* */
+	if ( scheduler->heads[worker] < scheduler->tails[worker] )
+		return scheduler->heads[worker]++;
+/* */
+	for ( register int i = 0; i < scheduler->nworkers; i++ ) {
+		if (
+			scheduler->heads[i] < scheduler->tails[i] &&
+			(victim < 0 || scheduler->tails[i] - scheduler->heads[i] > scheduler->tails[victim] - scheduler->heads[victim])
+		) {
+			victim = i;
+		}
+	}
+
+	return victim < 0 ? -1 : --scheduler->tails[victim];
+}
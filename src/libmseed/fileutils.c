@@ -28,15 +28,20 @@
 
 #include "libmseed.h"
 #include "msio.h"
+#include "unpack.h"
 
 /* Skip length in bytes when skipping non-data */
 #define SKIPLEN 1
 
+/* Count of consecutive equal length records before striding with MSF_FIXEDRECLEN */
+#define FIXEDRECLEN_DETECT 4
+
 /* Initialize the global file reading parameters */
 MS3FileParam gMS3FileParam = MS3FileParam_INITIALIZER;
 
 /* Stream state flags */
 #define MSFP_RANGEAPPLIED 0x0001 //!< Byte ranging has been applied
+#define MSFP_MMAPWINDOW 0x0002   //!< Read buffer is a window into a file mapping
 
 static char *parse_pathname_range (const char *string, int64_t *start, int64_t *end);
 
@@ -204,6 +209,64 @@ ms3_shift_msfp (MS3FileParam *msfp, int shift)
 /* Macro to return current reading position */
 #define MSFPREADPTR(MSFP) (MSFP->readbuffer + MSFP->readoffset)
 
+/***************************************************************************
+ *
+ * A helper routine to parse the record at the reading position of a
+ * MSFP, see msr3_parse() for the return values.
+ *
+ * When ::MSF_FIXEDRECLEN is set and the previous FIXEDRECLEN_DETECT
+ * records were miniSEED 2 of the same length, the record is unpacked
+ * directly at that length, skipping format and length detection.  A
+ * record of another length (per blockette 1000) ends the striding and
+ * is parsed with full detection.
+ ***************************************************************************/
+static int
+ms3_parse_msfp (MS3FileParam *msfp, MS3Record **ppmsr, uint32_t pflags, int8_t verbose)
+{
+  const char *record = MSFPREADPTR (msfp);
+  int parseval;
+
+  if ((pflags & MSF_FIXEDRECLEN) && msfp->fixedcount >= FIXEDRECLEN_DETECT &&
+      MSFPBUFLEN (msfp) >= msfp->fixedreclen && MS2_ISVALIDHEADER (record))
+  {
+    if (msr3_unpack_mseed2 (record, msfp->fixedreclen, ppmsr, pflags & ~(MSF_UNPACKDATA), 0) ==
+            MS_NOERROR &&
+        (*ppmsr)->reclen == msfp->fixedreclen)
+    {
+      if ((pflags & MSF_UNPACKDATA) && (*ppmsr)->samplecnt > 0 &&
+          msr3_unpack_data (*ppmsr, verbose) != (*ppmsr)->samplecnt)
+      {
+        msr3_free (ppmsr);
+        return MS_GENERROR;
+      }
+
+      return MS_NOERROR;
+    }
+
+    /* Mismatch, fall back to full detection */
+    msfp->fixedreclen = 0;
+    msfp->fixedcount = 0;
+  }
+
+  parseval = msr3_parse (record, MSFPBUFLEN (msfp), ppmsr, pflags, verbose);
+
+  /* Track consecutive miniSEED 2 records of the same length */
+  if (parseval == MS_NOERROR && (pflags & MSF_FIXEDRECLEN))
+  {
+    if ((*ppmsr)->formatversion == 2 && (*ppmsr)->reclen == msfp->fixedreclen)
+    {
+      msfp->fixedcount++;
+    }
+    else
+    {
+      msfp->fixedreclen = ((*ppmsr)->formatversion == 2) ? (*ppmsr)->reclen : 0;
+      msfp->fixedcount = 1;
+    }
+  }
+
+  return parseval;
+} /* End of ms3_parse_msfp() */
+
 /***************************************************************************
  * Implementation of MS3Record reading functions
  *
@@ -257,7 +320,8 @@ _ms3_readmsr_impl (MS3FileParam **ppmsfp, MS3Record **ppmsr, const char *mspath,
     if (msfp->input.handle != NULL)
       msio_fclose (&msfp->input);
 
-    if (msfp->readbuffer != NULL)
+    /* A window into a file mapping was not allocated */
+    if (msfp->readbuffer != NULL && !(msfp->flags & MSFP_MMAPWINDOW))
       libmseed_memory.free (msfp->readbuffer);
 
     /* If the parameters are the global parameters reset them */
@@ -275,8 +339,8 @@ _ms3_readmsr_impl (MS3FileParam **ppmsfp, MS3Record **ppmsr, const char *mspath,
     return MS_NOERROR;
   }
 
-  /* Allocate reading buffer */
-  if (msfp->readbuffer == NULL)
+  /* Allocate reading buffer, not needed when reading through a file mapping */
+  if (msfp->readbuffer == NULL && !(msfp->flags & MSFP_MMAPWINDOW))
   {
     if (!(msfp->readbuffer = (char *)libmseed_memory.malloc (MAXRECLEN)))
     {
@@ -328,12 +392,23 @@ _ms3_readmsr_impl (MS3FileParam **ppmsfp, MS3Record **ppmsr, const char *mspath,
     }
     else
     {
-      if (msio_fopen (&msfp->input, msfp->path, "rb", &msfp->startoffset, &msfp->endoffset))
+      if (msio_fopen (&msfp->input, msfp->path, (flags & MSF_MMAPFILE) ? "rbm" : "rb",
+                      &msfp->startoffset, &msfp->endoffset))
       {
         msr3_free (ppmsr);
         return MS_GENERROR;
       }
 
+      /* Parse records in place from the mapping, release the unneeded read buffer */
+      if (msfp->input.type == LMIO_MMAP)
+      {
+        libmseed_memory.free (msfp->readbuffer);
+        msfp->readbuffer = NULL;
+        msfp->readlength = 0;
+        msfp->readoffset = 0;
+        msfp->flags |= MSFP_MMAPWINDOW;
+      }
+
       /* Set stream position to start offset */
       if (msfp->startoffset > 0)
       {
@@ -358,7 +433,24 @@ _ms3_readmsr_impl (MS3FileParam **ppmsfp, MS3Record **ppmsr, const char *mspath,
 
     /* Read more data into buffer if not at EOF and buffer has less than MINRECLEN
      * or more data is needed for the current record detected in buffer. */
-    if (!msio_feof (&msfp->input) && (MSFPBUFLEN (msfp) < MINRECLEN || parseval > 0))
+    if (!msio_feof (&msfp->input) && (MSFPBUFLEN (msfp) < MINRECLEN || parseval > 0) &&
+        (msfp->flags & MSFP_MMAPWINDOW))
+    {
+      /* Slide the window over the mapping to the stream position, nothing is copied */
+      readcount = (int)msio_fwindow (&msfp->input, msfp->streampos,
+                                     (const char **)&msfp->readbuffer, MAXRECLEN);
+
+      if (readcount < 0)
+      {
+        ms_log (2, "Error reading %s at offset %" PRId64 "\n", msfp->path, msfp->streampos);
+        retcode = MS_GENERROR;
+        break;
+      }
+
+      msfp->readlength = readcount;
+      msfp->readoffset = 0;
+    }
+    else if (!msio_feof (&msfp->input) && (MSFPBUFLEN (msfp) < MINRECLEN || parseval > 0))
     {
       /* Reset offsets if no unprocessed data in buffer */
       if (MSFPBUFLEN (msfp) <= 0)
@@ -396,7 +488,7 @@ _ms3_readmsr_impl (MS3FileParam **ppmsfp, MS3Record **ppmsr, const char *mspath,
       if (msio_feof (&msfp->input))
         pflags |= MSF_ATENDOFFILE;
 
-      parseval = msr3_parse (MSFPREADPTR (msfp), MSFPBUFLEN (msfp), ppmsr, pflags, verbose);
+      parseval = ms3_parse_msfp (msfp, ppmsr, pflags, verbose);
 
       /* Record detected and parsed */
       if (parseval == 0)
@@ -563,6 +655,8 @@ _ms3_readmsr_impl (MS3FileParam **ppmsfp, MS3Record **ppmsr, const char *mspath,
  *  - ::MSF_UNPACKDATA data samples will be unpacked
  *  - ::MSF_VALIDATECRC Validate CRC (if present in format)
  *  - ::MSF_PNAMERANGE Parse byte range suffix from @p mspath
+ *  - ::MSF_MMAPFILE Memory-map local files and parse records in place
+ *  - ::MSF_FIXEDRECLEN Stride through fixed-length miniSEED 2 records
  *
  * If ::MSF_PNAMERANGE is set in @p flags, the @p mspath will be
  * searched for start and end byte offsets for the file or URL in the
@@ -727,6 +821,9 @@ ms3_readtracelist_timewin (MS3TraceList **ppmstl, const char *mspath, const MS3T
  * If the ::MSF_RECORDLIST flag is set in @p flags, a ::MS3RecordList
  * will be built for each ::MS3TraceSeg.  The ::MS3RecordPtr entries
  * contain the location of the data record, bit flags, extra headers, etc.
+ * If ::MSF_MMAPFILE is also set and the file could be mapped, the
+ * entries reference the records in the mapping directly, which is
+ * kept until the trace list is freed.
  *
  * @param[out] ppmstl Pointer-to-pointer to a ::MS3TraceList to populate
  * @param[in] mspath File to read
@@ -819,7 +916,7 @@ ms3_readtracelist_selection (MS3TraceList **ppmstl, const char *mspath,
         break;
       }
 
-      recordptr->bufferptr = NULL;
+      recordptr->bufferptr = (msfp->flags & MSFP_MMAPWINDOW) ? msr->record : NULL;
       recordptr->fileptr = NULL;
       recordptr->filename = mspath;
       recordptr->fileoffset = msfp->streampos - msr->reclen;
@@ -832,6 +929,13 @@ ms3_readtracelist_selection (MS3TraceList **ppmstl, const char *mspath,
   if (retcode == MS_ENDOFFILE)
     retcode = MS_NOERROR;
 
+  /* Hand the file mapping over to the trace list, the record list references it */
+  if ((flags & MSF_RECORDLIST) && msfp && msfp->input.type == LMIO_MMAP)
+  {
+    if (msio_fdetach (&msfp->input, &(*ppmstl)->mappings))
+      retcode = MS_GENERROR;
+  }
+
   ms3_readmsr_selection (&msfp, &msr, NULL, 0, NULL, 0);
 
   return retcode;
@@ -24,8 +24,16 @@
 #include <errno.h>
 #include <stddef.h>
 
+#if !defined(LMP_WIN)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 #include "msio.h"
 
+static int msio_fmmap (LMIO *io, const char *path, int64_t *startoffset);
+
 /* Include libcurl library header if URL supported is requested */
 #if defined(LIBMSEED_URL)
 
@@ -167,7 +175,10 @@ header_callback (char *buffer, size_t size, size_t num, void *userdata)
  * initialize as appropriate.
  *
  * The 'mode' argument is only for file-system paths and ignored for
- * URLs.  If 'mode' is set to NULL, default is 'rb' mode.
+ * URLs.  If 'mode' is set to NULL, default is 'rb' mode.  If 'mode'
+ * contains 'm' a regular file is memory-mapped (LMIO_MMAP) instead
+ * of opened as a stream, falling back to 'rb' mode when the file
+ * cannot be mapped (e.g. empty, a pipe or a device).
  *
  * If 'startoffset' or 'endoffset' are non-zero they will be used to
  * position the stream for reading, either setting the read position
@@ -384,6 +395,15 @@ msio_fopen (LMIO *io, const char *path, const char *mode, int64_t *startoffset,
   }
   else
   {
+    /* Map the file if requested, otherwise (or if that fails) use a stream */
+    if (strchr (mode, 'm'))
+    {
+      if (msio_fmmap (io, path, startoffset) == 0)
+        return 0;
+
+      mode = "rb";
+    }
+
     io->type = LMIO_FILE;
 
     if ((io->handle = fopen (path, mode)) == NULL)
@@ -439,6 +459,16 @@ msio_fclose (LMIO *io)
       return -1;
     }
   }
+  else if (io->type == LMIO_MMAP)
+  {
+#if !defined(LMP_WIN)
+    if (munmap (io->handle, (size_t)io->mapsize))
+    {
+      ms_log (2, "Error unmapping file (%s)\n", strerror (errno));
+      return -1;
+    }
+#endif
+  }
   else if (io->type == LMIO_URL)
   {
 #if !defined(LIBMSEED_URL)
@@ -454,6 +484,8 @@ msio_fclose (LMIO *io)
   io->type = LMIO_NULL;
   io->handle = NULL;
   io->handle2 = NULL;
+  io->mapsize = 0;
+  io->mappos = 0;
 
   return 0;
 } /* End of msio_fclose() */
@@ -498,6 +530,16 @@ msio_fread (LMIO *io, void *buffer, size_t size)
   {
     read = fread (buffer, 1, size, io->handle);
   }
+  /* Copy from file mapping, msio_fwindow() avoids this copy */
+  else if (io->type == LMIO_MMAP)
+  {
+    if (io->mappos < io->mapsize)
+    {
+      read = ((int64_t)size < (io->mapsize - io->mappos)) ? size : (size_t)(io->mapsize - io->mappos);
+      memcpy (buffer, (char *)io->handle + io->mappos, read);
+      io->mappos += read;
+    }
+  }
   /* Read from URL stream */
   else if (io->type == LMIO_URL)
   {
@@ -608,6 +650,11 @@ msio_feof (LMIO *io)
     if (feof ((FILE *)io->handle))
       return 1;
   }
+  else if (io->type == LMIO_MMAP)
+  {
+    if (io->mappos >= io->mapsize)
+      return 1;
+  }
   else if (io->type == LMIO_URL)
   {
 #if !defined(LIBMSEED_URL)
@@ -625,6 +672,168 @@ msio_feof (LMIO *io)
   return 0;
 } /* End of msio_feof() */
 
+/*********************************************************************
+ * msio_fwindow:
+ *
+ * Return a window into a memory-mapped (LMIO_MMAP) IO handle without
+ * copying.  The 'window' pointer is set to the byte at 'offset' in
+ * the mapping and the read position is moved to the end of the
+ * window, which covers up to 'size' bytes.
+ *
+ * Returns the number of bytes in the window on success and a
+ * negative value on error.
+ *
+ * @ref MessageOnError - this function logs a message on error
+ *********************************************************************/
+int64_t
+msio_fwindow (LMIO *io, int64_t offset, const char **window, size_t size)
+{
+  int64_t length;
+
+  if (!io || !window)
+    return -1;
+
+  if (io->type != LMIO_MMAP)
+  {
+    ms_log (2, "%s(): IO handle is not a file mapping\n", __func__);
+    return -1;
+  }
+
+  if (offset < 0 || offset > io->mapsize)
+  {
+    ms_log (2, "%s(): Offset %" PRId64 " is outside of mapping\n", __func__, offset);
+    return -1;
+  }
+
+  length = io->mapsize - offset;
+  if ((uint64_t)length > size)
+    length = (int64_t)size;
+
+  *window = (const char *)io->handle + offset;
+  io->mappos = offset + length;
+
+  return length;
+} /* End of msio_fwindow() */
+
+/*********************************************************************
+ * msio_fdetach:
+ *
+ * Detach the mapping from a memory-mapped (LMIO_MMAP) IO handle and
+ * add it to the 'mappings' list, allowing pointers into the mapping
+ * to outlive the handle.  The handle is reset as if it was closed.
+ * Mappings are released with msio_freemappings().
+ *
+ * Returns 0 on success and -1 on error.
+ *
+ * @ref MessageOnError - this function logs a message on error
+ *********************************************************************/
+int
+msio_fdetach (LMIO *io, LMIOMapping **mappings)
+{
+  LMIOMapping *mapping;
+
+  if (!io || !mappings || io->type != LMIO_MMAP)
+    return -1;
+
+  if ((mapping = (LMIOMapping *)libmseed_memory.malloc (sizeof (LMIOMapping))) == NULL)
+  {
+    ms_log (2, "%s(): Cannot allocate memory for mapping entry\n", __func__);
+    return -1;
+  }
+
+  mapping->base = io->handle;
+  mapping->size = io->mapsize;
+  mapping->next = *mappings;
+  *mappings = mapping;
+
+  io->type = LMIO_NULL;
+  io->handle = NULL;
+  io->mapsize = 0;
+  io->mappos = 0;
+
+  return 0;
+} /* End of msio_fdetach() */
+
+/*********************************************************************
+ * msio_freemappings:
+ *
+ * Unmap and free all mappings in a list built by msio_fdetach().
+ *********************************************************************/
+void
+msio_freemappings (LMIOMapping **mappings)
+{
+  LMIOMapping *mapping;
+
+  if (!mappings)
+    return;
+
+  while ((mapping = *mappings) != NULL)
+  {
+    *mappings = mapping->next;
+
+#if !defined(LMP_WIN)
+    munmap (mapping->base, (size_t)mapping->size);
+#endif
+
+    libmseed_memory.free (mapping);
+  }
+} /* End of msio_freemappings() */
+
+/*********************************************************************
+ * msio_fmmap:
+ *
+ * Map a regular file read-only into memory and initialize the IO
+ * handle as LMIO_MMAP with the read position at 'startoffset'.
+ *
+ * Returns 0 on success and -1 if the file cannot be mapped, in which
+ * case the caller should fall back to stream reading.
+ *********************************************************************/
+static int
+msio_fmmap (LMIO *io, const char *path, int64_t *startoffset)
+{
+#if defined(LMP_WIN)
+  (void)io;          /* Unused */
+  (void)path;        /* Unused */
+  (void)startoffset; /* Unused */
+  return -1;
+#else
+  struct stat sb;
+  void *base;
+  int fd;
+
+  if ((fd = open (path, O_RDONLY)) < 0)
+    return -1;
+
+  /* Only non-empty regular files can be mapped */
+  if (fstat (fd, &sb) || !S_ISREG (sb.st_mode) || sb.st_size <= 0 ||
+      (uint64_t)sb.st_size > (uint64_t)SIZE_MAX)
+  {
+    close (fd);
+    return -1;
+  }
+
+  base = mmap (NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  /* The mapping stays valid after the descriptor is closed */
+  close (fd);
+
+  if (base == MAP_FAILED)
+    return -1;
+
+#if defined(MADV_SEQUENTIAL)
+  madvise (base, (size_t)sb.st_size, MADV_SEQUENTIAL);
+#endif
+
+  io->type = LMIO_MMAP;
+  io->handle = base;
+  io->handle2 = NULL;
+  io->mapsize = (int64_t)sb.st_size;
+  io->mappos = (startoffset && *startoffset > 0) ? *startoffset : 0;
+
+  return 0;
+#endif
+} /* End of msio_fmmap() */
+
 /*********************************************************************
  * msio_url_useragent:
  *
@@ -27,11 +27,22 @@ extern "C" {
 
 #include "libmseed.h"
 
+/* A file mapping detached from an LMIO, kept alive for record lists */
+typedef struct LMIOMapping
+{
+  void *base;               /* Base address of the mapping */
+  int64_t size;             /* Size of the mapping in bytes */
+  struct LMIOMapping *next; /* Next mapping, NULL if the last */
+} LMIOMapping;
+
 extern int msio_fopen (LMIO *io, const char *path, const char *mode,
                        int64_t *startoffset, int64_t *endoffset);
 extern int msio_fclose (LMIO *io);
 extern int64_t msio_fread (LMIO *io, void *buffer, size_t size);
 extern int msio_feof (LMIO *io);
+extern int64_t msio_fwindow (LMIO *io, int64_t offset, const char **window, size_t size);
+extern int msio_fdetach (LMIO *io, LMIOMapping **mappings);
+extern void msio_freemappings (LMIOMapping **mappings);
 extern int msio_url_useragent (const char *program, const char *version);
 extern int msio_url_userpassword (const char *userpassword);
 extern int msio_url_addheader (const char *header);
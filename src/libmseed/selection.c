@@ -29,6 +29,31 @@
 static int ms_isinteger (const char *string);
 static int ms_globmatch (const char *string, const char *pattern);
 
+/* Number of selections before they are compiled into an index for matching */
+#define MSSELECT_INDEX_MIN 16
+
+/* Compiled index of a selection list: the selections with a plain source ID
+ * are kept in a hash table, the ones with globbing characters are kept in a
+ * list with their literal prefixes to skip most of the glob evaluations.
+ * Selection entries are referred to by their position in the list. */
+typedef struct MS3SelectIndex
+{
+  uint32_t count;                 /* Number of selections in the list */
+  const MS3Selections **entries;  /* Selections in list order */
+  uint32_t hashmask;              /* Size of hash table - 1 */
+  uint32_t *hashhead;             /* First position + 1 of each hash slot, 0 for empty */
+  uint32_t *hashnext;             /* Next position + 1 in the same slot, in list order */
+  uint32_t npatterns;             /* Number of selections with globbing characters */
+  uint32_t *patterns;             /* Positions of selections with globbing characters */
+  uint8_t *prefixlen;             /* Literal prefix length of each pattern */
+} MS3SelectIndex;
+
+static MS3SelectIndex *ms_compileselections (const MS3Selections *selections);
+static void ms_freeselectindex (MS3SelectIndex *index);
+static const MS3SelectTime *ms_matchselecttime (const MS3Selections *selection, nstime_t starttime,
+                                                nstime_t endtime, int pubversion);
+static uint32_t ms_sidhash (const char *sid);
+
 /** ************************************************************************
  * @brief Test the specified parameters for a matching selection entry
  *
@@ -44,6 +69,11 @@ static int ms_globmatch (const char *string, const char *pattern);
  *  -# equal pubversion if selection pubversion > 0
  * @endparblock
  *
+ * Long selection lists are compiled into an index at the first call, so
+ * the cost of matching does not grow with the number of plain source ID
+ * selections.  The index is stored in the first ::MS3Selections entry, do
+ * the first call before sharing the selections between threads.
+ *
  * @param[in] selections ::MS3Selections to search
  * @param[in] sid Source ID to match
  * @param[in] starttime Start time to match
@@ -59,66 +89,75 @@ ms3_matchselect (const MS3Selections *selections, const char *sid, nstime_t star
                  nstime_t endtime, int pubversion, const MS3SelectTime **ppselecttime)
 {
   const MS3Selections *findsl = NULL;
-  const MS3SelectTime *findst = NULL;
   const MS3SelectTime *matchst = NULL;
+  MS3SelectIndex *index = NULL;
+  uint32_t exact = 0;
+  uint32_t pattern = 0;
+  uint32_t position;
+  uint32_t count = 0;
 
-  if (selections)
+  if (selections && sid)
   {
-    findsl = selections;
-    while (findsl)
+    /* Compile the index for long selection lists at first use */
+    if (!(index = selections->index))
     {
-      if (ms_globmatch (sid, findsl->sidpattern))
+      for (findsl = selections; findsl && count < MSSELECT_INDEX_MIN; findsl = findsl->next)
+        count++;
+
+      if (count >= MSSELECT_INDEX_MIN)
+        index = ((MS3Selections *)selections)->index = ms_compileselections (selections);
+    }
+
+    /* Walk the candidate selections in list order, merging the hash chain of
+     * the exact source ID with the patterns sharing its literal prefix */
+    if (index)
+    {
+      exact = index->hashhead[ms_sidhash (sid) & index->hashmask];
+
+      while (exact || pattern < index->npatterns)
       {
-        if (findsl->pubversion > 0 && findsl->pubversion != pubversion)
+        if (exact && (pattern >= index->npatterns || exact - 1 < index->patterns[pattern]))
         {
-          findsl = findsl->next;
-          continue;
-        }
+          position = exact - 1;
+          exact = index->hashnext[position];
 
-        /* If no time selection, this is a match */
-        if (!findsl->timewindows)
+          if (strcmp (sid, index->entries[position]->sidpattern))
+            continue;
+        }
+        else
         {
-          if (ppselecttime)
-            *ppselecttime = NULL;
+          position = index->patterns[pattern];
 
-          return findsl;
+          if (strncmp (sid, index->entries[position]->sidpattern, index->prefixlen[pattern++]) ||
+              !ms_globmatch (sid, index->entries[position]->sidpattern))
+            continue;
         }
 
-        /* Otherwise, search the time selections */
-        findst = findsl->timewindows;
-        while (findst)
+        if ((matchst = ms_matchselecttime (index->entries[position], starttime, endtime,
+                                           pubversion)))
         {
-          if (starttime != NSTERROR && starttime != NSTUNSET && findst->starttime != NSTERROR &&
-              findst->starttime != NSTUNSET &&
-              (starttime < findst->starttime &&
-               !(starttime <= findst->starttime && endtime >= findst->starttime)))
-          {
-            findst = findst->next;
-            continue;
-          }
-          else if (endtime != NSTERROR && endtime != NSTUNSET && findst->endtime != NSTERROR &&
-                   findst->endtime != NSTUNSET &&
-                   (endtime > findst->endtime &&
-                    !(starttime <= findst->endtime && endtime >= findst->endtime)))
-          {
-            findst = findst->next;
-            continue;
-          }
-
-          matchst = findst;
+          findsl = index->entries[position];
           break;
         }
       }
+    }
+    else
+    {
+      findsl = selections;
+      while (findsl)
+      {
+        if (ms_globmatch (sid, findsl->sidpattern) &&
+            (matchst = ms_matchselecttime (findsl, starttime, endtime, pubversion)))
+          break;
 
-      if (matchst)
-        break;
-      else
         findsl = findsl->next;
+      }
     }
   }
 
+  /* Selections without time windows match with no time window entry */
   if (ppselecttime)
-    *ppselecttime = matchst;
+    *ppselecttime = (matchst && findsl->timewindows) ? matchst : NULL;
 
   return (matchst) ? findsl : NULL;
 } /* End of ms3_matchselect() */
@@ -683,6 +722,7 @@ ms3_freeselections (MS3Selections *selections)
         selecttime = selecttimenext;
       }
 
+      ms_freeselectindex (select->index);
       libmseed_memory.free (select);
 
       select = selectnext;
@@ -738,6 +778,173 @@ ms3_printselections (const MS3Selections *selections)
   }
 } /* End of ms3_printselections() */
 
+/***************************************************************************
+ * ms_matchselecttime:
+ *
+ * Test the publication version and time windows of a selection whose
+ * source ID pattern has already matched.
+ *
+ * Returns the matching time window, NULL for no match.  A selection
+ * without time windows matches with a static empty time window, which
+ * callers translate to NULL.
+ ***************************************************************************/
+static const MS3SelectTime *
+ms_matchselecttime (const MS3Selections *selection, nstime_t starttime, nstime_t endtime,
+                    int pubversion)
+{
+  static const MS3SelectTime opentime = {NSTUNSET, NSTUNSET, NULL};
+  const MS3SelectTime *findst = NULL;
+
+  if (selection->pubversion > 0 && selection->pubversion != pubversion)
+    return NULL;
+
+  /* If no time selection, this is a match */
+  if (!selection->timewindows)
+    return &opentime;
+
+  /* Otherwise, search the time selections */
+  findst = selection->timewindows;
+  while (findst)
+  {
+    if (starttime != NSTERROR && starttime != NSTUNSET && findst->starttime != NSTERROR &&
+        findst->starttime != NSTUNSET &&
+        (starttime < findst->starttime &&
+         !(starttime <= findst->starttime && endtime >= findst->starttime)))
+    {
+      findst = findst->next;
+      continue;
+    }
+    else if (endtime != NSTERROR && endtime != NSTUNSET && findst->endtime != NSTERROR &&
+             findst->endtime != NSTUNSET &&
+             (endtime > findst->endtime &&
+              !(starttime <= findst->endtime && endtime >= findst->endtime)))
+    {
+      findst = findst->next;
+      continue;
+    }
+
+    return findst;
+  }
+
+  return NULL;
+} /* End of ms_matchselecttime() */
+
+/***************************************************************************
+ * ms_compileselections:
+ *
+ * Compile the index of a selection list, see MS3SelectIndex.
+ *
+ * Returns a pointer to the index on success and NULL on error, in which
+ * case the list will be searched linearly.
+ ***************************************************************************/
+static MS3SelectIndex *
+ms_compileselections (const MS3Selections *selections)
+{
+  const MS3Selections *findsl = NULL;
+  MS3SelectIndex *index = NULL;
+  uint32_t *tail = NULL;
+  uint32_t hashsize = 1;
+  uint32_t position;
+  uint32_t slot;
+  size_t length;
+
+  if (!(index = (MS3SelectIndex *)libmseed_memory.malloc (sizeof (MS3SelectIndex))))
+    return NULL;
+  memset (index, 0, sizeof (MS3SelectIndex));
+
+  for (findsl = selections; findsl; findsl = findsl->next)
+    index->count++;
+
+  while (hashsize < index->count * 2)
+    hashsize <<= 1;
+
+  index->hashmask = hashsize - 1;
+  index->entries = (const MS3Selections **)libmseed_memory.malloc (index->count * sizeof (MS3Selections *));
+  index->hashhead = (uint32_t *)libmseed_memory.malloc (hashsize * sizeof (uint32_t));
+  index->hashnext = (uint32_t *)libmseed_memory.malloc (index->count * sizeof (uint32_t));
+  index->patterns = (uint32_t *)libmseed_memory.malloc (index->count * sizeof (uint32_t));
+  index->prefixlen = (uint8_t *)libmseed_memory.malloc (index->count * sizeof (uint8_t));
+  tail = (uint32_t *)libmseed_memory.malloc (hashsize * sizeof (uint32_t));
+
+  if (!index->entries || !index->hashhead || !index->hashnext || !index->patterns ||
+      !index->prefixlen || !tail)
+  {
+    libmseed_memory.free (tail);
+    ms_freeselectindex (index);
+    return NULL;
+  }
+
+  memset (index->hashhead, 0, hashsize * sizeof (uint32_t));
+
+  for (findsl = selections, position = 0; findsl; findsl = findsl->next, position++)
+  {
+    index->entries[position] = findsl;
+    index->hashnext[position] = 0;
+
+    length = strcspn (findsl->sidpattern, "*?[\\");
+
+    /* Plain source IDs are appended to the hash chain to keep list order */
+    if (findsl->sidpattern[length] == '\0')
+    {
+      slot = ms_sidhash (findsl->sidpattern) & index->hashmask;
+
+      if (index->hashhead[slot])
+        index->hashnext[tail[slot] - 1] = position + 1;
+      else
+        index->hashhead[slot] = position + 1;
+
+      tail[slot] = position + 1;
+    }
+    else
+    {
+      index->patterns[index->npatterns] = position;
+      index->prefixlen[index->npatterns++] = (uint8_t)length;
+    }
+  }
+
+  libmseed_memory.free (tail);
+
+  return index;
+} /* End of ms_compileselections() */
+
+/***************************************************************************
+ * ms_freeselectindex:
+ *
+ * Free all memory associated with a compiled selection index.
+ ***************************************************************************/
+static void
+ms_freeselectindex (MS3SelectIndex *index)
+{
+  if (!index)
+    return;
+
+  libmseed_memory.free (index->entries);
+  libmseed_memory.free (index->hashhead);
+  libmseed_memory.free (index->hashnext);
+  libmseed_memory.free (index->patterns);
+  libmseed_memory.free (index->prefixlen);
+  libmseed_memory.free (index);
+} /* End of ms_freeselectindex() */
+
+/***************************************************************************
+ * ms_sidhash:
+ *
+ * FNV-1a hash of a source ID.
+ ***************************************************************************/
+static uint32_t
+ms_sidhash (const char *sid)
+{
+  uint32_t hash = 2166136261u;
+
+  while (*sid)
+  {
+    hash ^= (uint8_t)*sid++;
+    hash *= 16777619u;
+  }
+
+  return hash;
+} /* End of ms_sidhash() */
+
 /***************************************************************************
  * ms_isinteger:
  *
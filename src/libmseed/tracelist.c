@@ -26,6 +26,7 @@
 
 #include "libmseed.h"
 #include "internalstate.h"
+#include "msio.h"
 
 static MS3TraceSeg *lm_msr2seg (const MS3Record *msr, nstime_t endtime);
 static MS3TraceSeg *lm_addmsrtoseg (MS3TraceSeg *seg, const MS3Record *msr, nstime_t endtime,
@@ -40,6 +41,28 @@ static int lm_remove_segment (MS3TraceList *mstl, MS3TraceID *id, MS3TraceSeg *s
 static uint32_t lm_lcg_r (uint64_t *state);
 static uint8_t lm_random_height (uint8_t maximum, uint64_t *state);
 
+/* Number of segments in a trace ID before the sorted segment index is built */
+#define MSTRACESEG_INDEX_MIN 32
+
+/* Sorted index of the segments of a trace ID, in the same order as the segment list.
+ * maxend[i] is the latest end time of segs[0] through segs[i], so that the first segment
+ * that could end at a given time can be found by binary search even with overlaps. */
+typedef struct MS3SegIndex
+{
+  uint32_t count;
+  uint32_t capacity;
+  MS3TraceSeg **segs;
+  nstime_t *maxend;
+} MS3SegIndex;
+
+static MS3SegIndex *lm_segindex_build (MS3TraceID *id);
+static void lm_segindex_free (MS3TraceID *id);
+static MS3SegIndex *lm_segindex_insert (MS3TraceID *id, uint32_t position, MS3TraceSeg *seg);
+static void lm_segindex_remove (MS3SegIndex *index, uint32_t position);
+static uint32_t lm_segindex_sort (MS3SegIndex *index, uint32_t position);
+static void lm_segindex_refresh (MS3SegIndex *index, uint32_t from, uint32_t to);
+static uint32_t lm_segindex_lowerbound (const MS3SegIndex *index, nstime_t starttime);
+
 /* Test if two sample rates are similar using either specified tolerance (if positive) or default
  * tolerance */
 #define IS_SAMPRATE_SIMILAR(SR1, SR2, SRT) \
@@ -131,11 +154,15 @@ mstl3_free (MS3TraceList **ppmstl, int8_t freeprvtptr)
     if (freeprvtptr && id->prvtptr)
       libmseed_memory.free (id->prvtptr);
 
+    lm_segindex_free (id);
     libmseed_memory.free (id);
 
     id = nextid;
   }
 
+  /* Release file mappings referenced by record lists */
+  msio_freemappings (&(*ppmstl)->mappings);
+
   libmseed_memory.free (*ppmstl);
 
   *ppmstl = NULL;
@@ -297,6 +324,15 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
   MS3TraceSeg *segafter = NULL;
   MS3TraceSeg *followseg = NULL;
 
+  MS3SegIndex *index = NULL;
+  uint32_t position = 0;
+  uint32_t idx;
+  uint32_t upper;
+  int64_t before;
+  int64_t after;
+  int64_t follow;
+  int64_t exact;
+
   nstime_t endtime;
   nstime_t pregap;
   nstime_t postgap;
@@ -413,6 +449,9 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
 
       seg = id->last;
 
+      if ((index = id->segindex))
+        position = index->count - 1;
+
       if (endtime > id->latest)
         id->latest = endtime;
 
@@ -432,6 +471,9 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
       id->last = seg;
       id->numsegments++;
 
+      if (id->segindex)
+        index = lm_segindex_insert (id, (position = id->segindex->count), seg);
+
       if (endtime > id->latest)
         id->latest = endtime;
 
@@ -451,6 +493,8 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
       id->first = seg;
       id->numsegments++;
 
+      index = lm_segindex_insert (id, (position = 0), seg);
+
       if (msr->starttime < id->earliest)
         id->earliest = msr->starttime;
 
@@ -467,6 +511,8 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
         return NULL;
 
       seg = id->first;
+      index = id->segindex;
+      position = 0;
 
       if (msr->starttime < id->earliest)
         id->earliest = msr->starttime;
@@ -482,7 +528,111 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
       segbefore = NULL; /* The first segment end that matches the record start (within tolerance) */
       segafter = NULL;  /* The first segment start that matches the record end (within tolerance) */
       followseg = NULL; /* The segment with latest start time before the record start */
-      searchseg = id->first;
+
+      /* Fragmented traces are searched thru the sorted segment index instead of the list,
+       * finding the same segments as the linear search below */
+      if (!(index = id->segindex) && id->numsegments >= MSTRACESEG_INDEX_MIN)
+        index = lm_segindex_build (id);
+
+      before = after = follow = exact = -1;
+      searchseg = (index) ? NULL : id->first;
+
+      if (index)
+      {
+        /* Done searching at the segment exactly matching the record if autohealing */
+        upper = index->count;
+        if (autoheal)
+        {
+          for (idx = lm_segindex_lowerbound (index, msr->starttime);
+               idx < index->count && index->segs[idx]->starttime == msr->starttime; idx++)
+          {
+            if (SEGMENT_HAS_TIME_COVERAGE (index->segs[idx]) &&
+                index->segs[idx]->endtime == endtime)
+            {
+              exact = idx;
+              upper = idx;
+              break;
+            }
+          }
+        }
+
+        /* The first segment ending within tolerance of the record start, all the segments
+         * before the first one with maxend reaching the lower limit end earlier */
+        idx = 0;
+        for (uint32_t count = upper; count > 0;)
+        {
+          uint32_t step = count / 2;
+
+          if (index->maxend[idx + step] < msr->starttime - nsperiod - nstimetol)
+          {
+            idx += step + 1;
+            count -= step + 1;
+          }
+          else
+          {
+            count = step;
+          }
+        }
+        for (; idx < upper && index->segs[idx]->starttime <= msr->starttime - nsperiod - nnstimetol; idx++)
+        {
+          searchseg = index->segs[idx];
+          postgap = msr->starttime - searchseg->endtime - nsperiod;
+
+          if (SEGMENT_HAS_TIME_COVERAGE (searchseg) && postgap <= nstimetol &&
+              postgap >= nnstimetol &&
+              IS_SAMPRATE_SIMILAR (sampratehz, searchseg->samprate, sampratetol))
+          {
+            before = idx;
+            break;
+          }
+        }
+
+        /* The first segment starting within tolerance of the record end */
+        for (idx = lm_segindex_lowerbound (index, endtime + nsperiod + nnstimetol);
+             idx < upper && index->segs[idx]->starttime <= endtime + nsperiod + nstimetol; idx++)
+        {
+          searchseg = index->segs[idx];
+
+          if (SEGMENT_HAS_TIME_COVERAGE (searchseg) &&
+              IS_SAMPRATE_SIMILAR (sampratehz, searchseg->samprate, sampratetol))
+          {
+            after = idx;
+            break;
+          }
+        }
+
+        /* Without autohealing the linear search stops at the first match of either */
+        if (!autoheal && before >= 0 && after >= 0)
+        {
+          if (before < after)
+            after = -1;
+          else if (after < before)
+            before = -1;
+        }
+
+        /* The segment with latest start time before the record start */
+        if (exact >= 0)
+        {
+          follow = exact;
+        }
+        else
+        {
+          for (idx = lm_segindex_lowerbound (index, msr->starttime); idx > 0; idx--)
+          {
+            if (SEGMENT_HAS_TIME_COVERAGE (index->segs[idx - 1]))
+            {
+              follow = idx - 1;
+              break;
+            }
+          }
+        }
+
+        segbefore = (before >= 0) ? index->segs[before] : NULL;
+        segafter = (after >= 0) ? index->segs[after] : NULL;
+        followseg = (follow >= 0) ? index->segs[follow] : NULL;
+        searchseg = NULL;
+      }
+
       while (searchseg)
       {
         /* Skip segments with no time coverage, these cannot be extended */
@@ -542,6 +692,12 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
           return NULL;
         }
 
+        if (index)
+        {
+          position = (uint32_t)before;
+          lm_segindex_refresh (index, position, position);
+        }
+
         /* Add MS3RecordPtr if requested */
         if (pprecptr && !(*pprecptr = lm_add_recordptr (segbefore, msr, endtime, 1)))
         {
@@ -571,6 +727,13 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
           lm_free_segment_memory (segafter, 1);
 
           id->numsegments -= 1;
+
+          if (index)
+          {
+            lm_segindex_remove (index, (uint32_t)after);
+            if (after < before)
+              position--;
+          }
         }
 
         seg = segbefore;
@@ -583,6 +746,8 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
           return NULL;
         }
 
+        position = (uint32_t)after;
+
         /* Add MS3RecordPtr if requested */
         if (pprecptr && !(*pprecptr = lm_add_recordptr (segafter, msr, endtime, 2)))
         {
@@ -629,6 +794,9 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
         }
 
         id->numsegments++;
+
+        if (index)
+          index = lm_segindex_insert (id, (position = (uint32_t)(follow + 1)), seg);
       }
     } /* End of searching segment list */
 
@@ -696,6 +864,10 @@ _mstl3_addmsr_impl (MS3TraceList *mstl, const MS3Record *msr, MS3RecordPtr **ppr
       id->last = segbefore;
   }
 
+  /* Move the modified segment into the same place in the segment index */
+  if (index)
+    lm_segindex_sort (index, position);
+
   /* Store update time at seg.prvtptr, allocate if needed */
   if (seg && flags & MSF_PPUPDATETIME)
   {
@@ -1164,6 +1336,224 @@ lm_addmsrtoseg (MS3TraceSeg *seg, const MS3Record *msr, nstime_t endtime, int8_t
   return seg;
 } /* End of lm_addmsrtoseg() */
 
+/***************************************************************************
+ * Build the sorted segment index of a trace ID from its segment list.
+ *
+ * Return a pointer to the MS3SegIndex, or NULL on error, in which case
+ * the segment list will be searched linearly.
+ ***************************************************************************/
+static MS3SegIndex *
+lm_segindex_build (MS3TraceID *id)
+{
+  MS3SegIndex *index = NULL;
+  MS3TraceSeg *seg = NULL;
+  uint32_t capacity;
+
+  capacity = id->numsegments * 2;
+
+  if (!(index = (MS3SegIndex *)libmseed_memory.malloc (sizeof (MS3SegIndex))))
+    return NULL;
+
+  index->segs = (MS3TraceSeg **)libmseed_memory.malloc (capacity * sizeof (MS3TraceSeg *));
+  index->maxend = (nstime_t *)libmseed_memory.malloc (capacity * sizeof (nstime_t));
+
+  if (!index->segs || !index->maxend)
+  {
+    libmseed_memory.free (index->segs);
+    libmseed_memory.free (index->maxend);
+    libmseed_memory.free (index);
+    return NULL;
+  }
+
+  index->capacity = capacity;
+  index->count = 0;
+
+  for (seg = id->first; seg && index->count < capacity; seg = seg->next)
+    index->segs[index->count++] = seg;
+
+  lm_segindex_refresh (index, 0, index->count);
+
+  id->segindex = index;
+
+  return index;
+} /* End of lm_segindex_build() */
+
+/***************************************************************************
+ * Free the sorted segment index of a trace ID, if any.
+ ***************************************************************************/
+static void
+lm_segindex_free (MS3TraceID *id)
+{
+  if (!id || !id->segindex)
+    return;
+
+  libmseed_memory.free (id->segindex->segs);
+  libmseed_memory.free (id->segindex->maxend);
+  libmseed_memory.free (id->segindex);
+
+  id->segindex = NULL;
+} /* End of lm_segindex_free() */
+
+/***************************************************************************
+ * Insert a new segment into the sorted segment index of a trace ID at
+ * the specified position.
+ *
+ * Return a pointer to the MS3SegIndex, or NULL if the trace ID has no
+ * index or when it is dropped on allocation error.
+ ***************************************************************************/
+static MS3SegIndex *
+lm_segindex_insert (MS3TraceID *id, uint32_t position, MS3TraceSeg *seg)
+{
+  MS3SegIndex *index = id->segindex;
+  MS3TraceSeg **newsegs = NULL;
+  nstime_t *newmaxend = NULL;
+  uint32_t capacity;
+
+  if (!index)
+    return NULL;
+
+  if (index->count >= index->capacity)
+  {
+    capacity = index->capacity * 2;
+    newsegs = (MS3TraceSeg **)libmseed_memory.realloc (index->segs,
+                                                       capacity * sizeof (MS3TraceSeg *));
+    if (newsegs)
+      index->segs = newsegs;
+
+    newmaxend = (nstime_t *)libmseed_memory.realloc (index->maxend, capacity * sizeof (nstime_t));
+    if (newmaxend)
+      index->maxend = newmaxend;
+
+    if (!newsegs || !newmaxend)
+    {
+      lm_segindex_free (id);
+      return NULL;
+    }
+
+    index->capacity = capacity;
+  }
+
+  memmove (index->segs + position + 1, index->segs + position,
+           (index->count - position) * sizeof (MS3TraceSeg *));
+  memmove (index->maxend + position + 1, index->maxend + position,
+           (index->count - position) * sizeof (nstime_t));
+
+  index->segs[position] = seg;
+  index->count++;
+
+  lm_segindex_refresh (index, position, position);
+
+  return index;
+} /* End of lm_segindex_insert() */
+
+/***************************************************************************
+ * Remove the segment at the specified position from a sorted segment index.
+ ***************************************************************************/
+static void
+lm_segindex_remove (MS3SegIndex *index, uint32_t position)
+{
+  index->count--;
+
+  memmove (index->segs + position, index->segs + position + 1,
+           (index->count - position) * sizeof (MS3TraceSeg *));
+  memmove (index->maxend + position, index->maxend + position + 1,
+           (index->count - position) * sizeof (nstime_t));
+
+  lm_segindex_refresh (index, position, position);
+} /* End of lm_segindex_remove() */
+
+/***************************************************************************
+ * Move the modified segment at the specified position into place, in the
+ * same manner as the segment list is sorted in _mstl3_addmsr_impl().
+ *
+ * Return the new position of the segment.
+ ***************************************************************************/
+static uint32_t
+lm_segindex_sort (MS3SegIndex *index, uint32_t position)
+{
+  MS3TraceSeg **segs = index->segs;
+  MS3TraceSeg *seg = segs[position];
+  uint32_t original = position;
+
+  while (position + 1 < index->count &&
+         (seg->starttime > segs[position + 1]->starttime ||
+          (seg->starttime == segs[position + 1]->starttime &&
+           seg->endtime < segs[position + 1]->endtime)))
+  {
+    segs[position] = segs[position + 1];
+    segs[++position] = seg;
+  }
+  while (position > 0 &&
+         (seg->starttime < segs[position - 1]->starttime ||
+          (seg->starttime == segs[position - 1]->starttime &&
+           seg->endtime > segs[position - 1]->endtime)))
+  {
+    segs[position] = segs[position - 1];
+    segs[--position] = seg;
+  }
+
+  if (position < original)
+    lm_segindex_refresh (index, position, original);
+  else
+    lm_segindex_refresh (index, original, position);
+
+  return position;
+} /* End of lm_segindex_sort() */
+
+/***************************************************************************
+ * Recalculate the running latest end times of a sorted segment index
+ * starting at position @p from.  Entries after position @p to that are
+ * unchanged stop the recalculation, as all following entries are current.
+ ***************************************************************************/
+static void
+lm_segindex_refresh (MS3SegIndex *index, uint32_t from, uint32_t to)
+{
+  nstime_t maxend;
+  uint32_t idx;
+
+  for (idx = from; idx < index->count; idx++)
+  {
+    maxend = index->segs[idx]->endtime;
+
+    if (idx > 0 && index->maxend[idx - 1] > maxend)
+      maxend = index->maxend[idx - 1];
+
+    if (idx > to && index->maxend[idx] == maxend)
+      break;
+
+    index->maxend[idx] = maxend;
+  }
+} /* End of lm_segindex_refresh() */
+
+/***************************************************************************
+ * Find the position of the first segment in a sorted segment index with
+ * a start time not earlier than @p starttime.
+ ***************************************************************************/
+static uint32_t
+lm_segindex_lowerbound (const MS3SegIndex *index, nstime_t starttime)
+{
+  uint32_t position = 0;
+  uint32_t count = index->count;
+  uint32_t step;
+
+  while (count > 0)
+  {
+    step = count / 2;
+
+    if (index->segs[position + step]->starttime < starttime)
+    {
+      position += step + 1;
+      count -= step + 1;
+    }
+    else
+    {
+      count = step;
+    }
+  }
+
+  return position;
+} /* End of lm_segindex_lowerbound() */
+
 /***************************************************************************
  * Add data coverage from seg2 to seg1.
  *
@@ -2235,6 +2625,10 @@ mstl3_pack_next (MS3TraceListPacker *packer, uint32_t flags, char **record, int3
       /* If MSF_MAINTAINMSTL not set, update segment data buffer: remove packed samples */
       if ((packer->flags & MSF_MAINTAINMSTL) == 0 && seg_total_packed > 0 && packer->current_seg)
       {
+        /* Start time is changing, drop the segment index */
+        if (packer->current_id)
+          lm_segindex_free (packer->current_id);
+
         /* Calculate new start time */
         if (seg_total_packed == packer->current_seg->numsamples)
           packer->current_seg->starttime = packer->current_seg->endtime;
@@ -2652,6 +3046,9 @@ mstl3_pack_segment (MS3TraceList *mstl, MS3TraceID *id, MS3TraceSeg *seg,
   /* If MSF_MAINTAINMSTL not set, modify or remove segment accordingly */
   if ((flags & MSF_MAINTAINMSTL) == 0 && segpackedsamples > 0)
   {
+    /* Start time is changing, drop the segment index */
+    lm_segindex_free (id);
+
     /* Calculate new start time, shortcut when all samples have been packed */
     if (segpackedsamples == seg->numsamples)
       seg->starttime = seg->endtime;
@@ -3140,6 +3537,9 @@ lm_remove_segment (MS3TraceList *mstl, MS3TraceID *id, MS3TraceSeg *seg, int8_t
   /* Decrement segment count */
   id->numsegments -= 1;
 
+  /* Drop the segment index, it will be rebuilt when needed */
+  lm_segindex_free (id);
+
   /* Free all memory associated with the segment */
   lm_free_segment_memory (seg, freeprvtptr);
 
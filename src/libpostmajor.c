@@ -0,0 +1,957 @@
+/**
+ * @file libpostmajor.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief The reentrant processing library of postmajor, from the loading of input seismic data to the peak
+ *        values & lead times of each station. There is no file-level state, all the options & the opened
+ *        input are kept in the context, so it can be embedded or called by several threads, one context for
+ *        each of them.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+/* */
+#include <postmajor.h>
+#include <libpostmajor.h>
+#include <seisdata_load.h>
+#include <iirfilter.h>
+#include <picker_wu.h>
+#include <trace_cache.h>
+
+/* */
+static int    pick_pwave_arrival( SNL_INFO *, const double );
+static void   proc_acc( const POSTMAJOR_CONTEXT *, SNL_INFO *, const int );
+static void   proc_vel( const POSTMAJOR_CONTEXT *, SNL_INFO *, const int );
+static void   proc_disp( const POSTMAJOR_CONTEXT *, SNL_INFO *, const int );
+static void   proc_leadtime( const POSTMAJOR_CONTEXT *, SNL_INFO * );
+static void   proc_waveforms( const POSTMAJOR_CONTEXT *, SNL_INFO *, const int, float *[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] );
+static void   proc_cached_traces( const POSTMAJOR_CONTEXT *, SNL_INFO *, const int, float *[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] );
+static void   keep_waveforms( const SNL_INFO *, float *[NUM_CHANNEL_SNL] );
+static void   integral_waveforms( SNL_INFO *, const int, const _Bool );
+static void   differential_waveform( SNL_INFO *, const int );
+static float *_integral_waveform( float *, const int, const double, const _Bool );
+static float *_differential_waveform( float *, const int, const double );
+static float *highpass_filter( float *, const int, const double, const _Bool );
+static float  calc_tau_c( const float *, const float *, const int, const float, const int );
+static float  calc_peak_value( const float *, const int, const float, const int );
+static void   mask_unselected_metrics( const POSTMAJOR_CONTEXT *, SNL_INFO * );
+
+/**
+ * @brief Initialize the context with the default options, the input is SAC & nothing is opened.
+ *
+ * @param ctx
+ */
+void postmajor_context_init( POSTMAJOR_CONTEXT *ctx )
+{
+	memset(ctx, 0, sizeof(POSTMAJOR_CONTEXT));
+	ctx->metrics             = METRIC_ALL;
+	ctx->pd_warn_threshold   = DEF_PD_WARN_THRESHOLD;
+	ctx->pga_warn_threshold  = DEF_PGA_WARN_THRESHOLD;
+	ctx->pga_watch_threshold = DEF_PGA_WATCH_THRESHOLD;
+	seisdata_context_init( &ctx->loader );
+	postmajor_context_input( ctx, "SAC", NULL );
+
+	return;
+}
+
+/**
+ * @brief Set the format & the path of the input seismic data, the loader is chosen by the format.
+ *
+ * @param ctx
+ * @param format
+ * @param path
+ * @return int
+ */
+int postmajor_context_input( POSTMAJOR_CONTEXT *ctx, const char *format, const char *path )
+{
+/* */
+	if ( !strcmp(format, "SAC") ) {
+		ctx->load     = seisdata_load_sac;
+		ctx->release  = seisdata_release_sac;
+		ctx->identify = seisdata_identify_sac;
+	}
+	else if ( !strcmp(format, "MSEED") || !strcmp(format, "MSEED3") ) {
+		ctx->load     = seisdata_load_ms;
+		ctx->release  = seisdata_release_ms;
+		ctx->identify = seisdata_identify_file;
+	}
+	else if ( !strcmp(format, "TANK") ) {
+		ctx->load     = seisdata_load_tank;
+		ctx->release  = seisdata_release_tank;
+		ctx->identify = seisdata_identify_file;
+	}
+	else if ( !strcmp(format, "SDS") ) {
+		ctx->load     = seisdata_load_sds;
+		ctx->release  = seisdata_release_sds;
+		ctx->identify = seisdata_identify_sds;
+	}
+	else if ( !strcmp(format, "PME") ) {
+		ctx->load     = seisdata_load_pme;
+		ctx->release  = seisdata_release_pme;
+		ctx->identify = seisdata_identify_file;
+	}
+	else {
+		fprintf(stderr, "Unknown format: %s\n", format);
+		return -1;
+	}
+/* */
+	strncpy(ctx->format, format, POSTMAJOR_FORMAT_LEN - 1);
+	ctx->path = path;
+
+	return 0;
+}
+
+/**
+ * @brief Set the origin time of the event, the loader can skip the data outside of the event window.
+ *
+ * @param ctx
+ * @param origin_time
+ */
+void postmajor_context_event( POSTMAJOR_CONTEXT *ctx, const double origin_time )
+{
+	ctx->origin_time = origin_time;
+	seisdata_window_set( &ctx->loader, origin_time - EV_PRE_DURATION, origin_time + EV_DURATION + EV_PRE_DURATION );
+
+	return;
+}
+
+/**
+ * @brief Release the opened input of the context, the options are kept.
+ *
+ * @param ctx
+ */
+void postmajor_context_release( POSTMAJOR_CONTEXT *ctx )
+{
+	if ( ctx->release )
+		ctx->release( &ctx->loader );
+
+	return;
+}
+
+/**
+ * @brief Process one station from the loading to the lead times with the options of the context, the seismic
+ *        data of the station is released after the processing & only the result is left.
+ *
+ * @param ctx
+ * @param snl_info
+ * @return int
+ */
+int postmajor_process_station( POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info )
+{
+/* */
+	if ( postmajor_load_station( ctx, snl_info ) < 0 )
+		return -1;
+/* */
+	postmajor_pick_station( ctx, snl_info );
+	postmajor_proc_station( ctx, snl_info, false, NULL );
+	postmajor_snl_free( snl_info );
+
+	return 0;
+}
+
+/**
+ * @brief Load the seismic data of the station from the input of the context, the station is reset when failed.
+ *
+ * @param ctx
+ * @param snl_info
+ * @return int
+ */
+int postmajor_load_station( POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info )
+{
+	if ( ctx->load( &ctx->loader, snl_info, ctx->path ) < 0 ) {
+		postmajor_snl_free( snl_info );
+		postmajor_snl_init( snl_info );
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Identify the input seismic data of the station, e.g. the sizes & modification times of its files.
+ *
+ * @param ctx
+ * @param snl_info
+ * @param identity
+ * @param size
+ * @return int
+ */
+int postmajor_identify_station( const POSTMAJOR_CONTEXT *ctx, const SNL_INFO *snl_info, char *identity, const size_t size )
+{
+	return ctx->identify( &ctx->loader, snl_info, ctx->path, identity, size );
+}
+
+/**
+ * @brief Pick the P arrival of the station, scanning from the origin time. Without valid picking, the start
+ *        point of scanning is kept as the arrival.
+ *
+ * @param ctx
+ * @param snl_info
+ * @return int
+ */
+int postmajor_pick_station( const POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info )
+{
+/* */
+	if ( !(snl_info->result->pick_flag = pick_pwave_arrival( snl_info, ctx->origin_time )) ) {
+	/* */
+		if ( snl_info->state->parrival_pos > snl_info->state->npts )
+			snl_info->state->parrival_pos = 0;
+		fprintf(
+			stderr, "Can't find valid P arrival (Np: %d, SNR: %lf), skip those time related parameters for SNL %s.%s.%s.\n",
+			snl_info->state->parrival_pos, snl_info->result->snr, snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc
+		);
+	}
+
+	return snl_info->result->pick_flag;
+}
+
+/**
+ * @brief Process the station after the picking, from the acceleration to the lead times. The traces of each
+ *        stage will be kept when the buffers are given.
+ *
+ * @param ctx
+ * @param snl_info
+ * @param cached
+ * @param traces
+ * @return int
+ */
+int postmajor_proc_station( const POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info, const _Bool cached, float *traces[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] )
+{
+	const int duration = ctx->metrics & METRIC_NEED_FULL ? EV_DURATION : PWAVE_PEAK_DURATION;
+
+	int end_pos;
+
+/* Only the P-wave window is needed when none of the peak values & lead times is selected */
+	if ( (end_pos = snl_info->state->parrival_pos + (int)(duration / snl_info->state->delta) + 1) > snl_info->state->npts )
+		end_pos = snl_info->state->npts;
+/* */
+	snl_info->state->sum_vel = calloc(snl_info->state->npts, sizeof(float));
+	snl_info->state->sum_dis = calloc(snl_info->state->npts, sizeof(float));
+/* */
+	if ( cached )
+		proc_cached_traces( ctx, snl_info, end_pos, traces );
+	else
+		proc_waveforms( ctx, snl_info, end_pos, traces );
+/* Computation of Tau-c at 3 seconds */
+	if ( ctx->metrics & METRIC_TC )
+		snl_info->result->tc = calc_tau_c(
+			&snl_info->state->sum_dis[snl_info->state->parrival_pos],
+			&snl_info->state->sum_vel[snl_info->state->parrival_pos],
+			end_pos, snl_info->state->delta, 3
+		);
+/* Finally, derive the lead time information */
+	proc_leadtime( ctx, snl_info );
+	if ( ctx->metrics != METRIC_ALL )
+		mask_unselected_metrics( ctx, snl_info );
+
+	return end_pos;
+}
+
+/**
+ * @brief Copy the event window of the context out of the loaded record, e.g. the continuous record shared by
+ *        several events, as if only this window was loaded: the mean of its head is removed again, then it can
+ *        be picked & processed as a single event. So the demeaning & the integration restart at each event
+ *        & the earlier events within the record never drift into the later ones.
+ *
+ * @param ctx
+ * @param record
+ * @param snl_info
+ * @return int
+ */
+int postmajor_slice_station( const POSTMAJOR_CONTEXT *ctx, const SNL_INFO *record, SNL_INFO *snl_info )
+{
+	const double delta = record->state->delta;
+
+	int   start = (int)((ctx->origin_time - EV_PRE_DURATION - record->state->starttime) / delta + 0.5);
+	int   end   = (int)((ctx->origin_time + EV_DURATION + EV_PRE_DURATION - record->state->starttime) / delta + 0.5) + 1;
+	int   npts;
+	int   head;
+	float mean;
+
+/* */
+	if ( start < 0 )
+		start = 0;
+	if ( end > record->state->npts )
+		end = record->state->npts;
+	if ( (npts = end - start) <= 0 ) {
+		fprintf(stderr, "ERROR! There is no data of %s.%s.%s within the event window!\n", snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc);
+		return -1;
+	}
+/* The same head as the loaders' demeaning */
+	if ( (head = (int)(npts * 0.1)) < (int)(1.0 / delta) )
+		head = npts;
+/* */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		if ( !(snl_info->state->seis[i] = (float *)malloc(npts * sizeof(float))) ) {
+			fprintf(stderr, "ERROR! Out of memory for %d float samples\n", npts);
+			postmajor_snl_free( snl_info );
+			return -1;
+		}
+		memcpy(snl_info->state->seis[i], record->state->seis[i] + start, npts * sizeof(float));
+	/* */
+		mean = 0.0;
+		for ( register int j = 0; j < head; j++ )
+			mean += snl_info->state->seis[i][j];
+		mean /= head;
+		for ( register int j = 0; j < npts; j++ )
+			snl_info->state->seis[i][j] -= mean;
+	}
+/* */
+	snl_info->state->npts      = npts;
+	snl_info->state->delta     = delta;
+	snl_info->state->starttime = record->state->starttime + start * delta;
+
+	return 0;
+}
+
+/**
+ * @brief Derive the lead times from the warning positions of PGA & Pd with their thresholds, the NA lead
+ *        time is only changed when Pd reaches its threshold.
+ *
+ * @param snl_info
+ * @param pga_warn_thr
+ * @param pd_warn_thr
+ * @param pga_warn_pos
+ * @param pd_warn_pos
+ * @param na_leadtime
+ * @param pga_leadtime
+ * @param pgv_leadtime
+ */
+void postmajor_derive_leadtime(
+	const SNL_INFO *snl_info, const float pga_warn_thr, const float pd_warn_thr, const int pga_warn_pos, const int pd_warn_pos,
+	float *na_leadtime, float *pga_leadtime, float *pgv_leadtime
+) {
+/* */
+	if ( (snl_info->state->pga_pos - pd_warn_pos) <= (snl_info->state->pga_pos - pga_warn_pos) )
+		*pga_leadtime = (snl_info->state->pga_pos - pga_warn_pos) * snl_info->state->delta;
+	else
+		*pga_leadtime = (snl_info->state->pga_pos - pd_warn_pos) * snl_info->state->delta;
+/* */
+	if ( (snl_info->state->pgv_pos - pd_warn_pos) <= (snl_info->state->pgv_pos - pga_warn_pos) )
+		*pgv_leadtime = (snl_info->state->pgv_pos - pga_warn_pos) * snl_info->state->delta;
+	else
+		*pgv_leadtime = (snl_info->state->pgv_pos - pd_warn_pos) * snl_info->state->delta;
+/* */
+	if ( snl_info->result->pga >= pga_warn_thr && snl_info->state->pd >= pd_warn_thr )
+		*na_leadtime = (pga_warn_pos - pd_warn_pos) * snl_info->state->delta;
+	else if ( snl_info->state->pd >= pd_warn_thr )
+		*na_leadtime = -1.0;
+/* */
+	if ( *na_leadtime < 0.0 )
+		*na_leadtime = NAN;
+	if ( *pga_leadtime < 0.0 )
+		*pga_leadtime = NAN;
+	if ( *pgv_leadtime < 0.0 )
+		*pgv_leadtime = NAN;
+
+	return;
+}
+
+/**
+ * @brief Reset the state & result of the station to the unprocessed one.
+ *
+ * @param snl_info
+ */
+void postmajor_snl_init( SNL_INFO *snl_info )
+{
+/* */
+	snl_info->state->npts         = -1;
+	snl_info->state->delta        = -1.0;
+	snl_info->state->starttime    = -1.0;
+	snl_info->result->pick_flag   = 0;
+	snl_info->state->parrival_pos = -1;
+	snl_info->state->sarrival_pos = -1;
+	snl_info->result->snr         = 0.0;
+/* Derived from waveform */
+	snl_info->result->pga = 0.0;
+	snl_info->result->pgv = 0.0;
+	snl_info->result->pgd = 0.0;
+	snl_info->result->pa3 = 0.0;
+	snl_info->result->pv3 = 0.0;
+	snl_info->result->pd3 = 0.0;
+	snl_info->result->tc  = 0.0;
+	snl_info->state->pd   = 0.0;
+/* */
+	snl_info->state->sum_vel = NULL;
+	snl_info->state->sum_dis = NULL;
+/* */
+	snl_info->state->pga_pos   = -1;
+	snl_info->state->pgv_pos   = -1;
+	snl_info->state->pgd_pos   = -1;
+/* */
+	snl_info->state->pd_warn_pos   = -1;
+	snl_info->state->pga_warn_pos  = -1;
+	snl_info->state->pga_watch_pos = -1;
+/* */
+	snl_info->result->pga_leadtime = NAN;
+	snl_info->result->pgv_leadtime = NAN;
+	snl_info->result->na_leadtime  = NAN;
+
+	return;
+}
+
+/**
+ * @brief Free the seismic data & the summation buffers of the station.
+ *
+ * @param snl_info
+ */
+void postmajor_snl_free( SNL_INFO *snl_info )
+{
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		if ( snl_info->state->seis[i] ) {
+			free(snl_info->state->seis[i]);
+			snl_info->state->seis[i] = NULL;
+		}
+	}
+/* */
+	if ( snl_info->state->sum_vel ) {
+		free(snl_info->state->sum_vel);
+		snl_info->state->sum_vel = NULL;
+	}
+	if ( snl_info->state->sum_dis ) {
+		free(snl_info->state->sum_dis);
+		snl_info->state->sum_dis = NULL;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param snl_info
+ * @param origin_time
+ * @return int
+ */
+static int pick_pwave_arrival( SNL_INFO *snl_info, const double origin_time )
+{
+	int start_pick = (int)((origin_time - snl_info->state->starttime) / snl_info->state->delta);
+
+/* */
+	if ( start_pick < 0 )
+		start_pick = 0;
+/* */
+	snl_info->result->snr = 0.0;
+	if ( (snl_info->state->parrival_pos = pickwu_p_arrival_pick( snl_info->state->seis[0], snl_info->state->npts, snl_info->state->delta, 2, start_pick )) ) {
+		if ( pickwu_p_trigger_check( snl_info->state->seis[0], snl_info->state->npts, snl_info->state->delta, snl_info->state->parrival_pos ) ) {
+			if ( pickwu_p_arrival_quality_calc( snl_info->state->seis[0], snl_info->state->npts, snl_info->state->delta, snl_info->state->parrival_pos, &snl_info->result->snr ) < 4 ) {
+				return 1;
+			}
+		}
+	}
+/* */
+	snl_info->state->parrival_pos = start_pick;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param ctx
+ * @param snl_info
+ * @param end_pos
+ */
+static void proc_acc( const POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info, const int end_pos )
+{
+	float vec_sum[snl_info->state->npts];
+
+/* */
+	snl_info->state->pga_warn_pos = snl_info->state->pga_watch_pos = end_pos;
+/* */
+	if ( ctx->vec_sum ) {
+		for ( register int j = snl_info->state->parrival_pos; j < end_pos; j++ ) {
+			vec_sum[j] =
+				snl_info->state->seis[0][j] * snl_info->state->seis[0][j] +
+				snl_info->state->seis[1][j] * snl_info->state->seis[1][j] +
+				snl_info->state->seis[2][j] * snl_info->state->seis[2][j];
+			vec_sum[j] = sqrtf(vec_sum[j]);
+		/* */
+			if ( vec_sum[j] > ctx->pga_watch_threshold ) {
+			/* */
+				if ( j < snl_info->state->pga_watch_pos )
+					snl_info->state->pga_watch_pos = j;
+			/* */
+				if ( vec_sum[j] > ctx->pga_warn_threshold ) {
+					if ( j < snl_info->state->pga_warn_pos )
+						snl_info->state->pga_warn_pos = j;
+				}
+			}
+		/* */
+			if ( vec_sum[j] > snl_info->result->pga ) {
+				snl_info->result->pga    = vec_sum[j];
+				snl_info->state->pga_pos = j;
+			}
+		}
+	/* */
+		snl_info->result->pa3 = calc_peak_value( &vec_sum[snl_info->state->parrival_pos], end_pos, snl_info->state->delta, 3 );
+	}
+	else {
+		for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+			for ( register int j = snl_info->state->parrival_pos; j < end_pos; j++ ) {
+			/* */
+				if ( fabs(snl_info->state->seis[i][j]) > ctx->pga_watch_threshold ) {
+				/* */
+					if ( j < snl_info->state->pga_watch_pos )
+						snl_info->state->pga_watch_pos = j;
+				/* */
+					if ( fabs(snl_info->state->seis[i][j]) > ctx->pga_warn_threshold ) {
+						if ( j < snl_info->state->pga_warn_pos )
+							snl_info->state->pga_warn_pos = j;
+					}
+				}
+			/* */
+				if ( fabs(snl_info->state->seis[i][j]) > snl_info->result->pga ) {
+					snl_info->result->pga    = fabs(snl_info->state->seis[i][j]);
+					snl_info->state->pga_pos = j;
+				}
+			}
+		}
+	/* */
+		snl_info->result->pa3 = calc_peak_value( snl_info->state->seis[0] + snl_info->state->parrival_pos, end_pos, snl_info->state->delta, 3 );
+	}
+
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param ctx
+ * @param snl_info
+ * @param end_pos
+ */
+static void proc_vel( const POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info, const int end_pos )
+{
+	float vec_sum[snl_info->state->npts];
+
+/* */
+	if ( ctx->vec_sum ) {
+		for ( register int j = snl_info->state->parrival_pos; j < end_pos; j++ ) {
+			vec_sum[j] =
+				snl_info->state->seis[0][j] * snl_info->state->seis[0][j] +
+				snl_info->state->seis[1][j] * snl_info->state->seis[1][j] +
+				snl_info->state->seis[2][j] * snl_info->state->seis[2][j];
+		/* */
+			snl_info->state->sum_vel[j] = vec_sum[j] + snl_info->state->sum_vel[j > 0 ? j - 1 : 0];
+		/* */
+			vec_sum[j] = sqrtf(vec_sum[j]);
+		/* */
+			if ( vec_sum[j] > snl_info->result->pgv ) {
+				snl_info->result->pgv    = vec_sum[j];
+				snl_info->state->pgv_pos = j;
+			}
+		}
+	/* */
+		snl_info->result->pv3 = calc_peak_value( &vec_sum[snl_info->state->parrival_pos], end_pos, snl_info->state->delta, 3 );
+	}
+	else {
+		for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+			for ( register int j = snl_info->state->parrival_pos; j < end_pos; j++ ) {
+			/* */
+				if ( fabs(snl_info->state->seis[i][j]) > snl_info->result->pgv ) {
+					snl_info->result->pgv    = fabs(snl_info->state->seis[i][j]);
+					snl_info->state->pgv_pos = j;
+				}
+			}
+		}
+	/* */
+		for ( register int i = snl_info->state->parrival_pos; i < end_pos; i++ )
+			snl_info->state->sum_vel[i] = snl_info->state->seis[0][i] * snl_info->state->seis[0][i] + snl_info->state->sum_vel[i > 0 ? i - 1 : 0];
+	/* */
+		snl_info->result->pv3 = calc_peak_value( snl_info->state->seis[0] + snl_info->state->parrival_pos, end_pos, snl_info->state->delta, 3 );
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param ctx
+ * @param snl_info
+ * @param end_pos
+ */
+static void proc_disp( const POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info, const int end_pos )
+{
+	float vec_sum[snl_info->state->npts];
+
+/* */
+	snl_info->state->pd_warn_pos = end_pos;
+/* */
+	if ( ctx->vec_sum ) {
+		for ( register int j = snl_info->state->parrival_pos; j < end_pos; j++ ) {
+			vec_sum[j] =
+				snl_info->state->seis[0][j] * snl_info->state->seis[0][j] +
+				snl_info->state->seis[1][j] * snl_info->state->seis[1][j] +
+				snl_info->state->seis[2][j] * snl_info->state->seis[2][j];
+		/* */
+			snl_info->state->sum_dis[j] = vec_sum[j] + snl_info->state->sum_dis[j > 0 ? j - 1 : 0];
+		/* */
+			vec_sum[j] = sqrtf(vec_sum[j]);
+		/* */
+			if ( vec_sum[j] > ctx->pd_warn_threshold ) {
+				if ( j < snl_info->state->pd_warn_pos )
+					snl_info->state->pd_warn_pos = j;
+			}
+		/* */
+			if ( vec_sum[j] > snl_info->result->pgd ) {
+				snl_info->result->pgd    = vec_sum[j];
+				snl_info->state->pgd_pos = j;
+			}
+		}
+	/* Computation of Pd at 3 seconds */
+		snl_info->result->pd3 = calc_peak_value( &vec_sum[snl_info->state->parrival_pos], end_pos, snl_info->state->delta, 3 );
+	}
+	else {
+	/* */
+		for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+			for ( register int j = snl_info->state->parrival_pos; j < end_pos; j++ ) {
+			/* */
+				if ( i == 0 ) {
+					if ( fabs(snl_info->state->seis[i][j]) > snl_info->state->pd )
+						snl_info->state->pd = fabs(snl_info->state->seis[i][j]);
+					if ( fabs(snl_info->state->seis[i][j]) > ctx->pd_warn_threshold && j < snl_info->state->pd_warn_pos )
+						snl_info->state->pd_warn_pos = j;
+				}
+			/* */
+				if ( fabs(snl_info->state->seis[i][j]) > snl_info->result->pgd ) {
+					snl_info->result->pgd    = fabs(snl_info->state->seis[i][j]);
+					snl_info->state->pgd_pos = j;
+				}
+			}
+		}
+	/* */
+		for ( register int i = snl_info->state->parrival_pos; i < end_pos; i++ )
+			snl_info->state->sum_dis[i] = snl_info->state->seis[0][i] * snl_info->state->seis[0][i] + snl_info->state->sum_dis[i > 0 ? i - 1 : 0];
+	/* Computation of Pd at 3 seconds */
+		snl_info->result->pd3 = calc_peak_value( snl_info->state->seis[0] + snl_info->state->parrival_pos, end_pos, snl_info->state->delta, 3 );
+	}
+
+	return;
+}
+
+/**
+ * @brief Transform the raw acceleration into velocity & displacement & extract their peak values, the
+ *        traces of each stage will be kept into the buffers when they are given.
+ *
+ * @param ctx
+ * @param snl_info
+ * @param end_pos
+ * @param traces
+ */
+static void proc_waveforms( const POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info, const int end_pos, float *traces[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] )
+{
+/* The filters are causal, the samples after the processing window never change the ones within it */
+	const int npts = ctx->metrics & METRIC_NEED_FULL ? snl_info->state->npts : end_pos;
+
+/* First of all, process the raw acceleration sample */
+	if ( traces )
+		keep_waveforms( snl_info, traces[TRACE_CACHE_ACC] );
+	if ( ctx->metrics & METRIC_NEED_ACC )
+		proc_acc( ctx, snl_info, end_pos );
+/* */
+	if ( !(ctx->metrics & (METRIC_NEED_VEL | METRIC_NEED_DISP)) )
+		return;
+/* Fork the process depends on the two stage integral switch */
+	if ( ctx->two_stage ) {
+	/* Transform the acceleration sample to velocity sample */
+		integral_waveforms( snl_info, npts, true );
+	/* */
+		if ( traces )
+			keep_waveforms( snl_info, traces[TRACE_CACHE_VEL] );
+		if ( ctx->metrics & METRIC_NEED_VEL )
+			proc_vel( ctx, snl_info, end_pos );
+	/* Transform the velocity sample to displacement sample */
+		if ( ctx->metrics & METRIC_NEED_DISP ) {
+			integral_waveforms( snl_info, npts, true );
+		/* */
+			if ( traces )
+				keep_waveforms( snl_info, traces[TRACE_CACHE_DISP] );
+			proc_disp( ctx, snl_info, end_pos );
+		}
+	}
+	else {
+	/* Transform the acceleration sample directly to displacement sample */
+		integral_waveforms( snl_info, npts, false );
+		integral_waveforms( snl_info, npts, true );
+	/* */
+		if ( traces )
+			keep_waveforms( snl_info, traces[TRACE_CACHE_DISP] );
+		if ( ctx->metrics & METRIC_NEED_DISP )
+			proc_disp( ctx, snl_info, end_pos );
+	/* Then transform the displacement sample back to velocity sample */
+		if ( ctx->metrics & METRIC_NEED_VEL ) {
+			differential_waveform( snl_info, npts );
+		/* */
+			if ( traces )
+				keep_waveforms( snl_info, traces[TRACE_CACHE_VEL] );
+			proc_vel( ctx, snl_info, end_pos );
+		}
+	}
+
+	return;
+}
+
+/**
+ * @brief Extract the peak values from the cached traces of each stage, the traces will be released by the caller.
+ *
+ * @param ctx
+ * @param snl_info
+ * @param end_pos
+ * @param traces
+ */
+static void proc_cached_traces( const POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info, const int end_pos, float *traces[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] )
+{
+/* */
+	memcpy(snl_info->state->seis, traces[TRACE_CACHE_ACC], sizeof(snl_info->state->seis));
+	proc_acc( ctx, snl_info, end_pos );
+	memcpy(snl_info->state->seis, traces[TRACE_CACHE_VEL], sizeof(snl_info->state->seis));
+	proc_vel( ctx, snl_info, end_pos );
+	memcpy(snl_info->state->seis, traces[TRACE_CACHE_DISP], sizeof(snl_info->state->seis));
+	proc_disp( ctx, snl_info, end_pos );
+/* */
+	memset(snl_info->state->seis, 0, sizeof(snl_info->state->seis));
+
+	return;
+}
+
+/**
+ * @brief Copy the current traces of the station into the buffers.
+ *
+ * @param snl_info
+ * @param traces
+ */
+static void keep_waveforms( const SNL_INFO *snl_info, float *traces[NUM_CHANNEL_SNL] )
+{
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		if ( (traces[i] = (float *)malloc(snl_info->state->npts * sizeof(float))) )
+			memcpy(traces[i], snl_info->state->seis[i], snl_info->state->npts * sizeof(float));
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param ctx
+ * @param snl_info
+ */
+static void proc_leadtime( const POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info )
+{
+/* */
+	if ( !snl_info->result->pick_flag || !(ctx->metrics & METRIC_LEADTIME) || (snl_info->state->pd_warn_pos <= 0 && snl_info->state->pga_warn_pos <= 0) ) {
+		snl_info->result->na_leadtime = snl_info->result->pga_leadtime = snl_info->result->pgv_leadtime = NAN;
+	/* Reset the P-wave peak value 'cause there is not valid arrival time */
+		if ( !snl_info->result->pick_flag )
+			snl_info->result->pa3 = snl_info->result->pv3 = snl_info->result->pd3 = snl_info->result->tc = 0.0;
+	}
+	else {
+		postmajor_derive_leadtime(
+			snl_info, ctx->pga_warn_threshold, ctx->pd_warn_threshold, snl_info->state->pga_warn_pos, snl_info->state->pd_warn_pos,
+			&snl_info->result->na_leadtime, &snl_info->result->pga_leadtime, &snl_info->result->pgv_leadtime
+		);
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param snl_info
+ * @param npts
+ * @param filter_sw
+ */
+static void integral_waveforms( SNL_INFO *snl_info, const int npts, const _Bool filter_sw )
+{
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ )
+		_integral_waveform( snl_info->state->seis[i], npts, snl_info->state->delta, filter_sw );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param snl_info
+ * @param npts
+ */
+static void differential_waveform( SNL_INFO *snl_info, const int npts )
+{
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ )
+		_differential_waveform( snl_info->state->seis[i], npts, snl_info->state->delta );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param input
+ * @param npts
+ * @param delta
+ * @param filter_sw
+ * @return float*
+ */
+static float *_integral_waveform( float *input, const int npts, const double delta, const _Bool filter_sw )
+{
+	const float half_delta = delta * 0.5;
+
+	register float last_seis  = 0.0;
+	register float this_pseis = 0.0;
+
+/* */
+	for ( register int i = 0; i < npts; i++ ) {
+		this_pseis = (input[i] + last_seis) * half_delta + this_pseis;
+		last_seis  = input[i];
+		input[i]   = this_pseis;
+	}
+/* */
+	if ( filter_sw )
+		highpass_filter( input, npts, delta, false );
+
+	return input;
+}
+
+/**
+ * @brief
+ *
+ * @param input
+ * @param npts
+ * @param delta
+ * @return float*
+ */
+static float *_differential_waveform( float *input, const int npts, const double delta )
+{
+	register float last_seis  = 0.0;
+	register float this_pseis = 0.0;
+
+/* */
+	for ( register int i = 0; i < npts; i++ ) {
+		this_pseis = (input[i] - last_seis) / delta;
+		last_seis  = input[i];
+		input[i]   = this_pseis;
+	}
+
+	return input;
+}
+
+/**
+ * @brief
+ *
+ * @param input
+ * @param npts
+ * @param delta
+ * @param zero_phase
+ * @return float*
+ */
+static float *highpass_filter( float *input, const int npts, const double delta, const _Bool zero_phase )
+{
+	IIR_FILTER filter;
+	IIR_STAGE *stage;
+
+	filter = iirfilter_design( 2, IIR_HIGHPASS_FILTER, IIR_BUTTERWORTH, 0.075, 0.0, delta );
+	stage  = (IIR_STAGE *)calloc(filter.nsects, sizeof(IIR_STAGE));
+
+/* First time, forward filtering */
+	memset(stage, 0, sizeof(IIR_STAGE) * filter.nsects);
+	for ( register int i = 0; i < npts; i++ )
+		input[i] = iirfilter_apply( input[i], &filter, stage );
+/* Second time, backward filtering */
+	if ( zero_phase ) {
+		memset(stage, 0, sizeof(IIR_STAGE) * filter.nsects);
+		for ( register int i = npts - 1; i >= 0; i-- )
+			input[i] = iirfilter_apply( input[i], &filter, stage );
+	}
+/* */
+	free(stage);
+
+	return input;
+}
+
+/**
+ * @brief
+ *
+ * @param sum_dis
+ * @param sum_vel
+ * @param npts
+ * @param delta
+ * @param sec
+ * @return float
+ */
+static float calc_tau_c( const float *sum_dis, const float *sum_vel, const int npts, const float delta, const int sec )
+{
+	const int i_end = (int)(sec / delta);
+
+	float result = 0.0;
+
+/* */
+	if ( i_end < npts )
+		result = PI2 * sqrt(sum_dis[i_end] / sum_vel[i_end]);
+
+	return result > 10.0 ? 10.0 : result;
+}
+
+/**
+ * @brief
+ *
+ * @param input
+ * @param npts
+ * @param delta
+ * @param sec
+ * @return float
+ */
+static float calc_peak_value( const float *input, const int npts, const float delta, const int sec )
+{
+	const int i_end = (int)(sec / delta);
+
+	register float result = 0.0;
+
+/* */
+	if ( i_end > npts )
+		return 0.0;
+
+	for ( register int i = 1; i < i_end; i++ ) {
+	/* */
+		if ( fabs(input[i]) > result )
+			result = fabs(input[i]);
+	}
+
+	return result;
+}
+
+/**
+ * @brief Set the metrics those are not selected to nan, they might be derived partially or not at all.
+ *
+ * @param ctx
+ * @param snl_info
+ */
+static void mask_unselected_metrics( const POSTMAJOR_CONTEXT *ctx, SNL_INFO *snl_info )
+{
+	if ( !(ctx->metrics & METRIC_PGA) )
+		snl_info->result->pga = NAN;
+	if ( !(ctx->metrics & METRIC_PGV) )
+		snl_info->result->pgv = NAN;
+	if ( !(ctx->metrics & METRIC_PGD) )
+		snl_info->result->pgd = NAN;
+	if ( !(ctx->metrics & METRIC_PA3) )
+		snl_info->result->pa3 = NAN;
+	if ( !(ctx->metrics & METRIC_PV3) )
+		snl_info->result->pv3 = NAN;
+	if ( !(ctx->metrics & METRIC_PD3) )
+		snl_info->result->pd3 = NAN;
+	if ( !(ctx->metrics & METRIC_TC) )
+		snl_info->result->tc = NAN;
+
+	return;
+}
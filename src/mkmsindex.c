@@ -0,0 +1,57 @@
+/**
+ * @file mkmsindex.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Standalone program to build the record-level index sidecar of miniSEED files for postmajor.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/* */
+#include <postmajor.h>
+#include <msindex.h>
+
+/* */
+#define TOOL_NAME  "mkmsindex"
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char **argv )
+{
+	char    idxpath[MAX_STR_SIZE] = { 0 };
+	int64_t nrecords;
+	int     result = 0;
+
+/* */
+	if ( argc < 2 || !strcmp(argv[1], "-h") ) {
+		fprintf(stdout, "Usage: %s <input miniSEED file> [<input miniSEED file> ...]\n\n", TOOL_NAME);
+		fprintf(stdout,
+			"This program will build the record index of each miniSEED file,\n"
+			"and save it to '<input miniSEED file>.idx' for the -x option of %s.\n"
+			"\n", PROG_NAME
+		);
+		return argc < 2 ? -1 : 0;
+	}
+/* */
+	for ( register int i = 1; i < argc; i++ ) {
+		snprintf(idxpath, sizeof(idxpath), MSINDEX_FILE_NAME_FORMAT, argv[i]);
+		if ( (nrecords = msindex_build( argv[i], idxpath )) < 0 ) {
+			fprintf(stderr, "ERROR! Cannot build the index of %s\n", argv[i]);
+			result = -1;
+			continue;
+		}
+		fprintf(stderr, "Indexed %ld records of %s into %s.\n", (long)nrecords, argv[i], idxpath);
+	}
+
+	return result;
+}
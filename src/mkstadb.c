@@ -0,0 +1,52 @@
+/**
+ * @file mkstadb.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Standalone program to compile the station list into the binary station database for postmajor.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+/* */
+#include <postmajor.h>
+#include <stadb.h>
+
+/* */
+#define TOOL_NAME  "mkstadb"
+
+/**
+ * @brief
+ *
+ * @param argc
+ * @param argv
+ * @return int
+ */
+int main( int argc, char **argv )
+{
+	int nstations;
+
+/* */
+	if ( argc != 3 || !strcmp(argv[1], "-h") ) {
+		fprintf(stdout, "Usage: %s <input station list> <output station database>\n\n", TOOL_NAME);
+		fprintf(stdout,
+			"This program will compile the station list of %s, or the channel level\n"
+			"FDSN station text (fdsnws-station 'format=text'), into the binary station\n"
+			"database, it can be used as the station list of %s directly.\n"
+			"\n", PROG_NAME, PROG_NAME
+		);
+		return argc != 3 && (argc < 2 || strcmp(argv[1], "-h")) ? -1 : 0;
+	}
+/* */
+	if ( (nstations = stadb_compile( argv[1], argv[2] )) < 0 ) {
+		fprintf(stderr, "ERROR! Cannot compile the station list %s\n", argv[1]);
+		return -1;
+	}
+	fprintf(stderr, "Compiled %d stations of %s into %s.\n", nstations, argv[1], argv[2]);
+
+	return 0;
+}
@@ -0,0 +1,458 @@
+/**
+ * @file msindex.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Build & read the record-level index sidecar of miniSEED files, so that the records
+ *        overlapping a time window can be reached without scanning the whole file.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+/* */
+#include <sys/mman.h>
+#include <sys/stat.h>
+/* */
+#include <libmseed.h>
+#include <msindex.h>
+
+/* */
+#define MAX_FILE_NAME      512
+#define MSINDEX_HASH_SIZE  65536
+/* */
+typedef struct {
+	uint32_t       sid;
+	MSINDEX_RECORD rec;
+} RECORD_ENTRY;
+
+/* */
+static uint32_t    hash_sid( const char * );
+static int         compare_sid( const void *, const void * );
+static int         compare_entry( const void *, const void * );
+static const void *map_file( const char *, size_t * );
+
+/**
+ * @brief Scan the whole miniSEED file once & write the index of all its records to the sidecar file.
+ *
+ * @param mspath
+ * @param idxpath
+ * @return int64_t The number of indexed records, or negative value on error.
+ */
+int64_t msindex_build( const char *mspath, const char *idxpath )
+{
+	MS3FileParam  *msfp     = NULL;
+	MS3Record     *msr      = NULL;
+	FILE          *fd       = NULL;
+	MSINDEX_SID   *sids     = NULL;
+	RECORD_ENTRY  *entries  = NULL;
+	uint32_t      *rank     = NULL;
+	uint32_t      *hash     = NULL;
+	uint32_t       nsids    = 0;
+	uint32_t       maxsids  = 0;
+	uint64_t       nrecords = 0;
+	uint64_t       maxrecs  = 0;
+	uint32_t       last_sid = UINT32_MAX;
+	int64_t        result   = -1;
+	int            retcode;
+	char           tmppath[MAX_FILE_NAME] = { 0 };
+	struct stat    st;
+	MSINDEX_HEADER header;
+
+/* */
+	if ( stat(mspath, &st) ) {
+		fprintf(stderr, "Error getting the status of %s: %s\n", mspath, strerror(errno));
+		return -1;
+	}
+/* The hash table keeps the index+1 of SID, zero means empty slot */
+	if ( !(hash = (uint32_t *)calloc(MSINDEX_HASH_SIZE, sizeof(uint32_t))) ) {
+		fprintf(stderr, "ERROR! Out of memory for building the index of %s\n", mspath);
+		return -2;
+	}
+
+/* Go thru all the records, only the header will be parsed */
+	while ( (retcode = ms3_readmsr_r(&msfp, &msr, mspath, MSF_MMAPFILE | MSF_FIXEDRECLEN, 0)) == MS_NOERROR ) {
+	/* Records are mostly grouped by SID, so check the last one first */
+		if ( last_sid == UINT32_MAX || strcmp(sids[last_sid].sid, msr->sid) ) {
+			uint32_t h = hash_sid( msr->sid ) % MSINDEX_HASH_SIZE;
+		/* */
+			for ( ; hash[h] && strcmp(sids[hash[h] - 1].sid, msr->sid); h = (h + 1) % MSINDEX_HASH_SIZE );
+		/* New SID */
+			if ( !hash[h] ) {
+				if ( nsids >= MSINDEX_HASH_SIZE / 2 ) {
+					fprintf(stderr, "ERROR! Too many SIDs within %s\n", mspath);
+					goto end_process;
+				}
+				if ( nsids >= maxsids ) {
+					maxsids = maxsids ? maxsids * 2 : 64;
+					if ( !(sids = (MSINDEX_SID *)realloc(sids, maxsids * sizeof(MSINDEX_SID))) ) {
+						fprintf(stderr, "ERROR! Out of memory for building the index of %s\n", mspath);
+						goto end_process;
+					}
+				}
+				memset(&sids[nsids], 0, sizeof(MSINDEX_SID));
+				strncpy(sids[nsids].sid, msr->sid, LM_SIDLEN - 1);
+			/* Keep the original order at the 'first' field for ranking */
+				sids[nsids].first = nsids;
+				hash[h] = ++nsids;
+			}
+			last_sid = hash[h] - 1;
+		}
+	/* */
+		if ( nrecords >= maxrecs ) {
+			maxrecs = maxrecs ? maxrecs * 2 : 4096;
+			if ( !(entries = (RECORD_ENTRY *)realloc(entries, maxrecs * sizeof(RECORD_ENTRY))) ) {
+				fprintf(stderr, "ERROR! Out of memory for building the index of %s\n", mspath);
+				goto end_process;
+			}
+		}
+		memset(&entries[nrecords], 0, sizeof(RECORD_ENTRY));
+		entries[nrecords].sid           = last_sid;
+		entries[nrecords].rec.offset    = msfp->streampos - msr->reclen;
+		entries[nrecords].rec.starttime = msr->starttime;
+		entries[nrecords].rec.endtime   = msr3_endtime(msr);
+		entries[nrecords].rec.reclen    = msr->reclen;
+		entries[nrecords].rec.encoding  = (uint8_t)msr->encoding;
+		if ( entries[nrecords].rec.endtime - entries[nrecords].rec.starttime > sids[last_sid].max_span )
+			sids[last_sid].max_span = entries[nrecords].rec.endtime - entries[nrecords].rec.starttime;
+		sids[last_sid].count++;
+		nrecords++;
+	}
+/* */
+	if ( retcode != MS_ENDOFFILE ) {
+		fprintf(stderr, "ERROR! Cannot read miniSEED from file: %s\n", mspath);
+		goto end_process;
+	}
+
+/* Sort the SIDs by name, then remap the SID of each record into the sorted position */
+	if ( nsids ) {
+		qsort(sids, nsids, sizeof(MSINDEX_SID), compare_sid);
+		if ( !(rank = (uint32_t *)malloc(nsids * sizeof(uint32_t))) ) {
+			fprintf(stderr, "ERROR! Out of memory for building the index of %s\n", mspath);
+			goto end_process;
+		}
+		for ( register uint32_t i = 0; i < nsids; i++ )
+			rank[sids[i].first] = i;
+		for ( register uint64_t i = 0; i < nrecords; i++ )
+			entries[i].sid = rank[entries[i].sid];
+	/* Records are grouped by SID & ordered by start time */
+		qsort(entries, nrecords, sizeof(RECORD_ENTRY), compare_entry);
+		for ( register uint32_t i = 0, first = 0; i < nsids; i++ ) {
+			sids[i].first = first;
+			first += sids[i].count;
+		}
+	}
+
+/* Write to the temporary file then rename it, readers will never see a partial index */
+	snprintf(tmppath, sizeof(tmppath), "%s.tmp", idxpath);
+	if ( (fd = fopen(tmppath, "wb")) == (FILE *)NULL ) {
+		fprintf(stderr, "Error opening %s: %s\n", tmppath, strerror(errno));
+		goto end_process;
+	}
+/* */
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MSINDEX_MAGIC, sizeof(MSINDEX_MAGIC));
+	header.version   = MSINDEX_VERSION;
+	header.nsids     = nsids;
+	header.nrecords  = nrecords;
+	header.src_size  = (int64_t)st.st_size;
+	header.src_mtime = (int64_t)st.st_mtim.tv_sec * NSTMODULUS + st.st_mtim.tv_nsec;
+/* */
+	if ( fwrite(&header, sizeof(header), 1, fd) != 1 || (nsids && fwrite(sids, sizeof(MSINDEX_SID), nsids, fd) != nsids) ) {
+		fprintf(stderr, "Error writing %s: %s\n", tmppath, strerror(errno));
+		goto close_file;
+	}
+	for ( register uint64_t i = 0; i < nrecords; i++ ) {
+		if ( fwrite(&entries[i].rec, sizeof(MSINDEX_RECORD), 1, fd) != 1 ) {
+			fprintf(stderr, "Error writing %s: %s\n", tmppath, strerror(errno));
+			goto close_file;
+		}
+	}
+/* */
+	if ( fclose(fd) || rename(tmppath, idxpath) ) {
+		fprintf(stderr, "Error writing %s: %s\n", idxpath, strerror(errno));
+		fd = NULL;
+		goto remove_file;
+	}
+	result = (int64_t)nrecords;
+	goto end_process;
+
+close_file:
+	fclose(fd);
+remove_file:
+	remove(tmppath);
+end_process:
+	ms3_readmsr_r(&msfp, &msr, NULL, 0, 0);
+	free(hash);
+	free(rank);
+	free(sids);
+	free(entries);
+
+	return result;
+}
+
+/**
+ * @brief Map both the index sidecar & the miniSEED file into memory, the index will be rejected
+ *        when it is not consistent with the miniSEED file.
+ *
+ * @param mspath
+ * @param idxpath
+ * @return MSINDEX*
+ */
+MSINDEX *msindex_open( const char *mspath, const char *idxpath )
+{
+	MSINDEX    *result = NULL;
+	struct stat st;
+	size_t      expect;
+
+/* */
+	if ( stat(mspath, &st) ) {
+		fprintf(stderr, "Error getting the status of %s: %s\n", mspath, strerror(errno));
+		return NULL;
+	}
+	if ( !(result = (MSINDEX *)calloc(1, sizeof(MSINDEX))) ) {
+		fprintf(stderr, "ERROR! Out of memory for the index of %s\n", mspath);
+		return NULL;
+	}
+/* */
+	if ( !(result->header = (const MSINDEX_HEADER *)map_file( idxpath, &result->idx_size )) )
+		goto error_process;
+	if ( result->idx_size < sizeof(MSINDEX_HEADER) || memcmp(result->header->magic, MSINDEX_MAGIC, sizeof(MSINDEX_MAGIC)) ) {
+		fprintf(stderr, "WARNING! %s is not an index of miniSEED file.\n", idxpath);
+		goto error_process;
+	}
+/* */
+	expect = sizeof(MSINDEX_HEADER) + result->header->nsids * sizeof(MSINDEX_SID) + result->header->nrecords * sizeof(MSINDEX_RECORD);
+	if ( result->header->version != MSINDEX_VERSION || result->idx_size != expect ) {
+		fprintf(stderr, "WARNING! The index %s is in unsupported version or truncated.\n", idxpath);
+		goto error_process;
+	}
+/* The file rewritten within the same second should be caught, so the modification time is compared in nanoseconds */
+	if (
+		result->header->src_size != (int64_t)st.st_size ||
+		result->header->src_mtime != (int64_t)st.st_mtim.tv_sec * NSTMODULUS + st.st_mtim.tv_nsec
+	) {
+		fprintf(stderr, "WARNING! The index %s is out of date with %s.\n", idxpath, mspath);
+		goto error_process;
+	}
+/* */
+	result->sids    = (const MSINDEX_SID *)(result->header + 1);
+	result->records = (const MSINDEX_RECORD *)(result->sids + result->header->nsids);
+	if ( !(result->data = (const char *)map_file( mspath, &result->data_size )) )
+		goto error_process;
+	if ( !(result->path = strdup(mspath)) )
+		goto error_process;
+
+	return result;
+
+error_process:
+	msindex_close( result );
+	return NULL;
+}
+
+/**
+ * @brief Add the records of the SID overlapping the time window into the trace list, the record
+ *        list entries will point to the records in the mapped miniSEED file.
+ *
+ * @param index
+ * @param sid
+ * @param starttime
+ * @param endtime
+ * @param mstl
+ * @return int The number of added records, or negative value on error.
+ */
+int msindex_fetch( MSINDEX *index, const char *sid, const nstime_t starttime, const nstime_t endtime, MS3TraceList *mstl )
+{
+	const MSINDEX_SID    *_sid = NULL;
+	const MSINDEX_RECORD *recs;
+	MS3Record    *msr       = NULL;
+	MS3RecordPtr *recordptr = NULL;
+	uint32_t      dataoffset;
+	uint32_t      datasize;
+	int64_t       lower;
+	int64_t       upper;
+	int           result    = 0;
+
+/* Binary search of the SID */
+	lower = 0;
+	upper = (int64_t)index->header->nsids - 1;
+	while ( lower <= upper ) {
+		int64_t mid = (lower + upper) / 2;
+		int     cmp = strcmp(index->sids[mid].sid, sid);
+	/* */
+		if ( !cmp ) {
+			_sid = &index->sids[mid];
+			break;
+		}
+		else if ( cmp < 0 ) {
+			lower = mid + 1;
+		}
+		else {
+			upper = mid - 1;
+		}
+	}
+/* */
+	if ( !_sid )
+		return 0;
+
+/* Binary search of the first record which could still cover the window start, none of the records is longer than the span */
+	recs  = index->records + _sid->first;
+	lower = 0;
+	upper = _sid->count;
+	while ( starttime > INT64_MIN + _sid->max_span && lower < upper ) {
+		int64_t mid = (lower + upper) / 2;
+		if ( recs[mid].starttime < starttime - _sid->max_span )
+			lower = mid + 1;
+		else
+			upper = mid;
+	}
+
+/* */
+	for ( ; lower < _sid->count && recs[lower].starttime <= endtime; lower++ ) {
+	/* */
+		if ( recs[lower].endtime < starttime )
+			continue;
+		if ( recs[lower].offset < 0 || (uint64_t)(recs[lower].offset + recs[lower].reclen) > index->data_size ) {
+			fprintf(stderr, "ERROR! The record at offset %ld is out of the file %s\n", (long)recs[lower].offset, index->path);
+			result = -1;
+			break;
+		}
+	/* Only parse the header of this record, the data will be unpacked later thru the record list */
+		if ( msr3_parse(index->data + recs[lower].offset, recs[lower].reclen, &msr, MSF_VALIDATECRC, 0) != MS_NOERROR ) {
+			fprintf(stderr, "ERROR! Cannot parse the record at offset %ld of the file %s\n", (long)recs[lower].offset, index->path);
+			result = -1;
+			break;
+		}
+		if ( !mstl3_addmsr_recordptr(mstl, msr, &recordptr, 0, 1, 0, NULL) || msr3_data_bounds(msr, &dataoffset, &datasize) ) {
+			fprintf(stderr, "ERROR! Cannot add the record of %s into the trace list\n", sid);
+			result = -1;
+			break;
+		}
+	/* */
+		recordptr->bufferptr  = index->data + recs[lower].offset;
+		recordptr->fileptr    = NULL;
+		recordptr->filename   = index->path;
+		recordptr->fileoffset = recs[lower].offset;
+		recordptr->dataoffset = dataoffset;
+		recordptr->prvtptr    = NULL;
+		result++;
+	}
+/* */
+	msr3_free(&msr);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param index
+ */
+void msindex_close( MSINDEX *index )
+{
+/* */
+	if ( index ) {
+		if ( index->header )
+			munmap((void *)index->header, index->idx_size);
+		if ( index->data )
+			munmap((void *)index->data, index->data_size);
+		free((void *)index->path);
+		free(index);
+	}
+
+	return;
+}
+
+/**
+ * @brief FNV-1a hash of the SID string.
+ *
+ * @param sid
+ * @return uint32_t
+ */
+static uint32_t hash_sid( const char *sid )
+{
+	register uint32_t result = 2166136261u;
+
+/* */
+	for ( ; *sid; sid++ ) {
+		result ^= (uint8_t)*sid;
+		result *= 16777619u;
+	}
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_sid( const void *a, const void *b )
+{
+	return strcmp(((const MSINDEX_SID *)a)->sid, ((const MSINDEX_SID *)b)->sid);
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_entry( const void *a, const void *b )
+{
+	const RECORD_ENTRY *_a = (const RECORD_ENTRY *)a;
+	const RECORD_ENTRY *_b = (const RECORD_ENTRY *)b;
+
+/* */
+	if ( _a->sid != _b->sid )
+		return _a->sid < _b->sid ? -1 : 1;
+	if ( _a->rec.starttime != _b->rec.starttime )
+		return _a->rec.starttime < _b->rec.starttime ? -1 : 1;
+	if ( _a->rec.offset != _b->rec.offset )
+		return _a->rec.offset < _b->rec.offset ? -1 : 1;
+
+	return 0;
+}
+
+/**
+ * @brief Map the whole file read-only into memory.
+ *
+ * @param path
+ * @param size
+ * @return const void*
+ */
+static const void *map_file( const char *path, size_t *size )
+{
+	struct stat st;
+	void       *result;
+	int         fd;
+
+/* */
+	if ( (fd = open(path, O_RDONLY)) < 0 )
+		return NULL;
+	if ( fstat(fd, &st) || st.st_size <= 0 ) {
+		close(fd);
+		return NULL;
+	}
+/* */
+	result = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if ( result == MAP_FAILED ) {
+		fprintf(stderr, "Error mapping %s into memory: %s\n", path, strerror(errno));
+		return NULL;
+	}
+/* */
+	*size = (size_t)st.st_size;
+
+	return result;
+}
@@ -0,0 +1,336 @@
+/**
+ * @file pmevent.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Read & write the native event container of postmajor. The container is mapped into memory
+ *        & the stations are found by binary search on the sorted index, there is nothing to parse
+ *        or decode for reading the samples.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+/* */
+#include <sys/mman.h>
+#include <sys/stat.h>
+/* */
+#include <pmevent.h>
+
+/* */
+static int compare_station( const void *, const void * );
+static int compare_station_key( const char *, const char *, const char *, const PMEVENT_STATION * );
+static int write_padding( PMEVENT_WRITER * );
+
+/**
+ * @brief Map the container into memory & validate its header & index.
+ *
+ * @param path
+ * @return PMEVENT*
+ */
+PMEVENT *pmevent_open( const char *path )
+{
+	PMEVENT              *result = NULL;
+	const PMEVENT_HEADER *header = NULL;
+	void                 *ptr    = NULL;
+	int                   fd;
+	struct stat           st;
+
+/* */
+	if ( (fd = open(path, O_RDONLY)) < 0 ) {
+		fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+		return NULL;
+	}
+	if ( fstat(fd, &st) || st.st_size < (off_t)sizeof(PMEVENT_HEADER) ) {
+		fprintf(stderr, "Error getting the status of %s\n", path);
+		close(fd);
+		return NULL;
+	}
+	ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if ( ptr == MAP_FAILED ) {
+		fprintf(stderr, "Error mapping %s into memory: %s\n", path, strerror(errno));
+		return NULL;
+	}
+/* */
+	header = (const PMEVENT_HEADER *)ptr;
+	if (
+		memcmp(header->magic, PMEVENT_MAGIC, PMEVENT_MAGIC_LEN) || header->version != PMEVENT_VERSION ||
+		header->file_size != (uint64_t)st.st_size || header->index_offset > header->file_size ||
+		(header->file_size - header->index_offset) / sizeof(PMEVENT_STATION) < header->nstations
+	) {
+		fprintf(stderr, "ERROR! %s is not a valid or complete postmajor event container!\n", path);
+		munmap(ptr, (size_t)st.st_size);
+		return NULL;
+	}
+/* */
+	if ( !(result = (PMEVENT *)calloc(1, sizeof(PMEVENT))) ) {
+		fprintf(stderr, "ERROR! Out of memory for opening %s\n", path);
+		munmap(ptr, (size_t)st.st_size);
+		return NULL;
+	}
+	result->data     = (const char *)ptr;
+	result->size     = (size_t)st.st_size;
+	result->header   = header;
+	result->stations = (const PMEVENT_STATION *)(result->data + header->index_offset);
+
+	return result;
+}
+
+/**
+ * @brief Find the station entry by station, network & location code with binary search.
+ *
+ * @param pme
+ * @param sta
+ * @param net
+ * @param loc
+ * @return const PMEVENT_STATION*
+ */
+const PMEVENT_STATION *pmevent_station_find( const PMEVENT *pme, const char *sta, const char *net, const char *loc )
+{
+	uint32_t lower = 0;
+	uint32_t upper = pme->header->nstations;
+	uint32_t middle;
+	int      cmp;
+
+/* */
+	while ( lower < upper ) {
+		middle = lower + (upper - lower) / 2;
+		if ( !(cmp = compare_station_key( sta, net, loc, &pme->stations[middle] )) )
+			return &pme->stations[middle];
+		else if ( cmp < 0 )
+			upper = middle;
+		else
+			lower = middle + 1;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Get the mapped float32 samples of the channel, NULL when they are out of the container.
+ *
+ * @param pme
+ * @param station
+ * @param channel
+ * @return const float*
+ */
+const float *pmevent_channel_data( const PMEVENT *pme, const PMEVENT_STATION *station, const int channel )
+{
+	uint64_t offset;
+
+/* */
+	if ( channel < 0 || channel >= PMEVENT_NUM_CHANNEL || station->npts <= 0 )
+		return NULL;
+	offset = station->offset[channel];
+	if ( offset > pme->header->index_offset || (pme->header->index_offset - offset) / sizeof(float) < (uint64_t)station->npts )
+		return NULL;
+
+	return (const float *)(pme->data + offset);
+}
+
+/**
+ * @brief
+ *
+ * @param pme
+ */
+void pmevent_close( PMEVENT *pme )
+{
+	if ( pme ) {
+		if ( pme->data )
+			munmap((void *)pme->data, pme->size);
+		free(pme);
+	}
+
+	return;
+}
+
+/**
+ * @brief Create a new container for writing, the header will be completed when closing.
+ *
+ * @param path
+ * @return PMEVENT_WRITER*
+ */
+PMEVENT_WRITER *pmevent_writer_create( const char *path )
+{
+	PMEVENT_WRITER *result = NULL;
+	PMEVENT_HEADER  header;
+
+/* */
+	if ( !(result = (PMEVENT_WRITER *)calloc(1, sizeof(PMEVENT_WRITER))) ) {
+		fprintf(stderr, "ERROR! Out of memory for writing %s\n", path);
+		return NULL;
+	}
+	if ( !(result->fp = fopen(path, "wb")) ) {
+		fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+		free(result);
+		return NULL;
+	}
+/* Just a placeholder of the header */
+	memset(&header, 0, sizeof(header));
+	if ( fwrite(&header, sizeof(header), 1, result->fp) != 1 ) {
+		fprintf(stderr, "Error writing the header of %s\n", path);
+		fclose(result->fp);
+		free(result);
+		return NULL;
+	}
+	result->offset = sizeof(header);
+
+	return result;
+}
+
+/**
+ * @brief Append the channels of one station into the container, the offsets of the entry will be filled here.
+ *
+ * @param writer
+ * @param station
+ * @param seis
+ * @return int
+ */
+int pmevent_writer_append( PMEVENT_WRITER *writer, const PMEVENT_STATION *station, float * const seis[PMEVENT_NUM_CHANNEL] )
+{
+	PMEVENT_STATION *entry = NULL;
+
+/* */
+	if ( writer->nstations == writer->capacity ) {
+		uint32_t         _capacity = writer->capacity ? writer->capacity * 2 : 256;
+		PMEVENT_STATION *_stations = realloc(writer->stations, _capacity * sizeof(PMEVENT_STATION));
+
+		if ( !_stations ) {
+			fprintf(stderr, "ERROR! Out of memory for the container index!\n");
+			return -2;
+		}
+		writer->stations = _stations;
+		writer->capacity = _capacity;
+	}
+/* */
+	entry = &writer->stations[writer->nstations];
+	*entry = *station;
+	for ( register int i = 0; i < PMEVENT_NUM_CHANNEL; i++ ) {
+		if ( write_padding( writer ) < 0 )
+			return -2;
+		entry->offset[i] = writer->offset;
+		if ( fwrite(seis[i], sizeof(float), station->npts, writer->fp) != (size_t)station->npts ) {
+			fprintf(stderr, "ERROR! Cannot write the samples of %.8s.%.8s.%.8s into the container!\n", station->sta, station->net, station->loc);
+			return -2;
+		}
+		writer->offset += (uint64_t)station->npts * sizeof(float);
+	}
+	writer->nstations++;
+
+	return 0;
+}
+
+/**
+ * @brief Sort & write the station index, then complete the header & close the container.
+ *
+ * @param writer
+ * @return int
+ */
+int pmevent_writer_close( PMEVENT_WRITER *writer )
+{
+	PMEVENT_HEADER header;
+	int            result = 0;
+
+/* */
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, PMEVENT_MAGIC, PMEVENT_MAGIC_LEN);
+	header.version   = PMEVENT_VERSION;
+	header.nstations = writer->nstations;
+/* */
+	if ( writer->nstations )
+		qsort(writer->stations, writer->nstations, sizeof(PMEVENT_STATION), compare_station);
+	for ( register uint32_t i = 1; i < writer->nstations; i++ ) {
+		if ( !compare_station( &writer->stations[i - 1], &writer->stations[i] ) ) {
+			fprintf(
+				stderr, "WARNING! Duplicated station %.8s.%.8s.%.8s in the container, only one of them could be read!\n",
+				writer->stations[i].sta, writer->stations[i].net, writer->stations[i].loc
+			);
+		}
+	}
+	if ( write_padding( writer ) < 0 ) {
+		result = -2;
+	}
+	else {
+		header.index_offset = writer->offset;
+		header.file_size    = writer->offset + (uint64_t)writer->nstations * sizeof(PMEVENT_STATION);
+		if (
+			(writer->nstations && fwrite(writer->stations, sizeof(PMEVENT_STATION), writer->nstations, writer->fp) != writer->nstations) ||
+			fseek(writer->fp, 0, SEEK_SET) || fwrite(&header, sizeof(header), 1, writer->fp) != 1
+		) {
+			fprintf(stderr, "ERROR! Cannot write the index of the container!\n");
+			result = -2;
+		}
+	}
+/* */
+	if ( fclose(writer->fp) )
+		result = -2;
+	free(writer->stations);
+	free(writer);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_station( const void *a, const void *b )
+{
+	const PMEVENT_STATION *_a = (const PMEVENT_STATION *)a;
+
+	return compare_station_key( _a->sta, _a->net, _a->loc, (const PMEVENT_STATION *)b );
+}
+
+/**
+ * @brief
+ *
+ * @param sta
+ * @param net
+ * @param loc
+ * @param station
+ * @return int
+ */
+static int compare_station_key( const char *sta, const char *net, const char *loc, const PMEVENT_STATION *station )
+{
+	int result;
+
+/* */
+	if ( (result = strncmp(sta, station->sta, PMEVENT_CODE_LEN)) )
+		return result;
+	if ( (result = strncmp(net, station->net, PMEVENT_CODE_LEN)) )
+		return result;
+
+	return strncmp(loc, station->loc, PMEVENT_CODE_LEN);
+}
+
+/**
+ * @brief Pad the file to the alignment of data, then the mapped samples can be accessed directly.
+ *
+ * @param writer
+ * @return int
+ */
+static int write_padding( PMEVENT_WRITER *writer )
+{
+	static const char zeros[PMEVENT_DATA_ALIGN] = { 0 };
+	const size_t      padding = (PMEVENT_DATA_ALIGN - writer->offset % PMEVENT_DATA_ALIGN) % PMEVENT_DATA_ALIGN;
+
+/* */
+	if ( padding && fwrite(zeros, 1, padding, writer->fp) != padding ) {
+		fprintf(stderr, "ERROR! Cannot write the padding of the container!\n");
+		return -2;
+	}
+	writer->offset += padding;
+
+	return 0;
+}
@@ -18,47 +18,106 @@
 #include <time.h>
 #include <math.h>
 #include <errno.h>
+#include <unistd.h>
 /* */
 #include <postmajor.h>
-#include <seisdata_load.h>
-#include <iirfilter.h>
-#include <picker_wu.h>
+#include <libpostmajor.h>
+#include <pmevent.h>
+#include <trace_cache.h>
+#include <result_store.h>
+#include <station_index.h>
+#include <stadb.h>
+#include <catalog.h>
+
+/*----------------------------------------------------------------------*
+ * Definition of the shared data of the catalog mode, the station list *
+ * & its index are parsed once for all the events                       *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	SNL_META          *metas;
+	int                nstations;
+	STATION_INDEX     *index;
+	POSTMAJOR_CONTEXT *contexts;     /* one for each worker */
+} BATCH_SHARED;
+
+/*----------------------------------------------------------------------*
+ * Definition of the opened event of the catalog mode, the stations are *
+ * processed in the order of distance                                   *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	const CATALOG_EVENT *event;
+	SNL_TABLE            table;
+	int                 *order;
+} BATCH_EVENT;
+
+/*----------------------------------------------------------------------*
+ * Definition of one channel of the SNL list, for finding the channels  *
+ * listed more than once                                                *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	const SNL_META *meta;
+	int             chan;
+} SNL_CHANNEL;
 
 /* Internal Function Prototypes */
 static int    proc_argv( int, char * [] );
 static void   usage( void );
-static void   init_snl_info_params( SNL_INFO * );
-static int    parse_stalist_line( SNL_INFO *, const char * );
-static int    parse_stalist( SNL_INFO **, const char * );
+static int    parse_stalist_line( SNL_META *, const char * );
+static int    parse_stalist( SNL_META **, const char * );
+static int    load_stadb( SNL_META **, const STADB * );
+static _Bool  has_duplicate_channels( const SNL_META *, const int );
+static int    compare_channels( const void *, const void * );
+static int    alloc_snl_table( SNL_TABLE *, SNL_META *, const int, const int );
+static void   free_snl_table( SNL_TABLE * );
 static int    parse_eqinfo_file( const char *, float *, float *, float *, double * );
-static int    pick_pwave_arrival( SNL_INFO *, const double );
-static void   proc_acc( SNL_INFO *, const int );
-static void   proc_vel( SNL_INFO *, const int );
-static void   proc_disp( SNL_INFO *, const int );
-static void   proc_leadtime( SNL_INFO * );
-static void   integral_waveforms( SNL_INFO *, const _Bool );
-static void   differential_waveform( SNL_INFO * );
-static float *_integral_waveform( float *, const int, const double, const _Bool );
-static float *_differential_waveform( float *, const int, const double );
-static float *highpass_filter( float *, const int, const double, const _Bool );
-static float  calc_tau_c( const float *, const float *, const int, const float, const int );
-static float  calc_peak_value( const float *, const int, const float, const int );
-static double coor2distf( const double, const double, const double, const double );
+static void   proc_sweep( const SNL_INFO *, const int, float * const [TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL], float * );
+static int    first_crossing( const float *, const int, const int, const float );
+static int    parse_threshold_spec( const char *, float **, int * );
+static int    write_pmevent_station( PMEVENT_WRITER *, SNL_INFO * );
+static int    build_result_key( const SNL_INFO *, const char *, uint64_t * );
+static int    derive_epic_dists( const STATION_INDEX *, const SNL_TABLE *, const double, const double, int * );
+static void   output_header( FILE *, const _Bool, const _Bool, const _Bool );
+static void   output_station_rows( FILE *, const SNL_INFO *, const SNL_INFO *, const float * );
+static void   stream_station_rows( const SNL_INFO *, const SNL_INFO *, const float *, const int, const int );
+static void   proc_configurations( const SNL_INFO *, SNL_INFO * );
+static int    parse_configurations( const char * );
+static void   output_snl_result( FILE *, const SNL_INFO * );
+static int    parse_metrics( const char * );
+static _Bool  is_output_snl( const SNL_INFO * );
+static int    proc_catalog( void );
+static void  *open_catalog_event( const CATALOG_EVENT *, int *, void * );
+static void   proc_catalog_station( void *, const int, const int, void * );
+static int    close_catalog_event( void *, void * );
+static int    proc_sequence( void );
 /* */
 static _Bool  HeaderSwitch      = true;
 static _Bool  CoordinateSwitch  = false;
 static _Bool  IgnStaWithoutData = false;
 static _Bool  IgnStaWithoutPick = false;
-static _Bool  TwoStageIntegral  = false;
-static _Bool  VecSumSwitch      = false;
-static float  PdWarnThreshold   = DEF_PD_WARN_THRESHOLD;
-static float  PGAWarnThreshold  = DEF_PGA_WARN_THRESHOLD;
-static float  PGAWatchThreshold = DEF_PGA_WATCH_THRESHOLD;
+static float  MaxEpicDistance   = 0.0;
 static char  *EqInfoFile        = NULL;
 static char  *StaListFile       = NULL;
 static char  *SeisDataFile      = NULL;
-static int  (*LoadSeisdataFunc)( SNL_INFO *, const char * ) = seisdata_load_sac;
-static void (*ReleaseSeisdataFunc)( void ) = seisdata_release_sac;
+static char  *ContainerFile     = NULL;
+static char  *CacheDir          = NULL;
+static char   CacheKey[TRACE_CACHE_KEY_LEN] = { 0 };
+static char   InputFormat[POSTMAJOR_FORMAT_LEN] = { 0 };
+static char  *ResultStoreFile   = NULL;
+static float *SweepPGAThresholds = NULL;
+static int    SweepNumPGA        = 0;
+static float *SweepPdThresholds  = NULL;
+static int    SweepNumPd         = 0;
+static int    NumProcConfigs     = 0;
+static struct {
+	_Bool two_stage;
+	_Bool vec_sum;
+	char  tag[4];
+} ProcConfigs[MAX_PROC_CONFIGS];
+static _Bool  StreamOutput       = false;
+static char  *BatchOutputDir     = NULL;
+static int    NumWorkers         = 0;
+static _Bool  SequenceSwitch     = false;
+static POSTMAJOR_CONTEXT Context;
 
 /**
  * @brief
@@ -75,141 +134,244 @@ int main( int argc, char **argv )
 	float  edep;
 	double otime = 0.0;
 /* */
-	SNL_INFO *snl_infos    = NULL;
-	int       totalsnl     = 0;
-	int       end_pos      = 0;
+	SNL_META       *snl_metas = NULL;
+	SNL_TABLE       snl_table = { 0 };
+	SNL_INFO       *snl_infos = NULL;
+	PMEVENT_WRITER *container = NULL;
+	int             totalsnl  = 0;
+	int             end_pos   = 0;
+	_Bool           cached    = false;
+	_Bool           identified = false;
+	char            identity[TRACE_CACHE_KEY_LEN] = { 0 };
+	RESULT_STORE   *store     = NULL;
+	char            optkey[MAX_STR_SIZE] = { 0 };
+	uint64_t        reskey    = 0;
+	_Bool           keyed     = false;
+	float          *sweep     = NULL;
+	int             nsweep    = 0;
+	float          *traces[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] = { { NULL } };
+	SNL_TABLE       conf_table = { 0 };
+	SNL_INFO       *conf_infos = NULL;
+	int            *order     = NULL;
+	STATION_INDEX  *index     = NULL;
 
 /* Check command line arguments */
 	if ( proc_argv( argc, argv ) ) {
 		usage();
 		return -1;
 	}
+/* The eq. info is a catalog of events */
+	if ( BatchOutputDir )
+		return proc_catalog();
+/* All the events of the eq. info share the input seismic data */
+	if ( SequenceSwitch )
+		return proc_sequence();
 
 /* */
 	if ( parse_eqinfo_file( EqInfoFile, &elat, &elon, &edep, &otime ) < 0 )
 		return -1;
+/* The loaders can skip the data outside of the event window */
+	postmajor_context_event( &Context, otime );
+/* The cache only works for the input that can be identified, the files of each station are identified later */
+	if ( CacheDir && !strcmp(SeisDataFile, "-") ) {
+		fprintf(stderr, "WARNING! Cannot identify the input seismic data from the stream, the cache is disabled!\n");
+		CacheDir = NULL;
+	}
+	if (
+		CacheDir && trace_cache_key_build(
+			CacheKey, InputFormat, otime, Context.two_stage,
+			Context.loader.ms_index_switch, Context.loader.window_start, Context.loader.window_end
+		) < 0
+	) {
+		CacheKey[0] = '\0';
+	}
 /* */
-	if ( (totalsnl = parse_stalist( &snl_infos, StaListFile )) <= 0 )
+	if ( (totalsnl = parse_stalist( &snl_metas, StaListFile )) <= 0 )
+		return -1;
+	if ( alloc_snl_table( &snl_table, snl_metas, totalsnl, 1 ) < 0 )
+		return -1;
+	snl_infos = snl_table.infos;
+/* Only convert the input seismic data into the event container */
+	if ( ContainerFile && !(container = pmevent_writer_create( ContainerFile )) )
 		return -1;
+/* The configurations share the loading & picking, the results are kept for each of them */
+	if ( !container && NumProcConfigs ) {
+		if ( ResultStoreFile || CacheDir || SweepNumPGA ) {
+			fprintf(stderr, "WARNING! The result store, the trace cache & the sweep are disabled for multiple configurations!\n");
+			ResultStoreFile = CacheDir = NULL;
+			SweepNumPGA = SweepNumPd = 0;
+		}
+		if ( alloc_snl_table( &conf_table, snl_metas, totalsnl, NumProcConfigs ) < 0 )
+			return -1;
+		conf_infos = conf_table.infos;
+	}
+/* The cached traces & the sweep of thresholds need all the stages over the whole event window */
+	if ( !container && Context.metrics != METRIC_ALL && (CacheDir || SweepNumPGA) ) {
+		fprintf(stderr, "WARNING! The trace cache & the sweep are disabled for the selected metrics!\n");
+		CacheDir = NULL;
+		SweepNumPGA = SweepNumPd = 0;
+	}
+/* The sweep of thresholds needs the traces of every station, the stored result can't be used */
+	if ( !container && (nsweep = SweepNumPGA * SweepNumPd * 3) ) {
+		if ( ResultStoreFile ) {
+			fprintf(stderr, "WARNING! The result store is disabled for the sweep of thresholds!\n");
+			ResultStoreFile = NULL;
+		}
+		if ( !(sweep = (float *)malloc((size_t)totalsnl * nsweep * sizeof(float))) ) {
+			fprintf(stderr, "ERROR! Out of memory for the sweep of thresholds!\n");
+			return -1;
+		}
+		for ( register size_t i = 0; i < (size_t)totalsnl * nsweep; i++ )
+			sweep[i] = NAN;
+	}
+/* The stored result will be reused when the input & all the options are the same */
+	if ( !container && ResultStoreFile ) {
+		if ( !(store = result_store_open( ResultStoreFile )) )
+			return -1;
+		snprintf(
+			optkey, sizeof(optkey), "%s|%s|%d|%d|%.6f|%.4f|%.4f|%.2f|%.4f|%.4f|%.4f|%d|%d|%x|%d|%lld:%lld|%d",
+			VERSION, InputFormat, Context.two_stage, Context.vec_sum, otime, elat, elon, edep,
+			Context.pd_warn_threshold, Context.pga_warn_threshold, Context.pga_watch_threshold, EV_DURATION, EV_PRE_DURATION, Context.metrics,
+			Context.loader.ms_index_switch, (long long)Context.loader.window_start, (long long)Context.loader.window_end, IgnStaWithoutPick
+		);
+	}
 
-/* */
-	for ( register int i = 0; i < totalsnl; i++ ) {
-	/* */
-		snl_infos[i].epic_dist = coor2distf( elon, elat, snl_infos[i].longitude, snl_infos[i].latitude );
+/* The epicentral distances from the station index, the stations beyond the maximum distance are not visited */
+	if (
+		!(order = (int *)malloc(totalsnl * sizeof(int))) || !(index = station_index_build( snl_metas, totalsnl )) ||
+		derive_epic_dists( index, &snl_table, elon, elat, order ) < 0
+	) {
+		return -1;
+	}
+	station_index_free( index );
+/* The header should be ahead of the streamed results */
+	if ( StreamOutput && !container )
+		output_header( stdout, conf_infos != NULL, sweep != NULL, false );
+
+/* The stations are processed from the closest one to the epicenter */
+	for ( register int k = 0; k < totalsnl; k++ ) {
+		const int i = order[k];
+
+	/* The previous station is done, whichever way it was left */
+		if ( StreamOutput && !container && k )
+			stream_station_rows( snl_infos, conf_infos, sweep, nsweep, order[k - 1] );
+	/* The station beyond the maximum distance won't be output, even the loading could be skipped */
+		if ( MaxEpicDistance > 0.0 && snl_infos[i].result->epic_dist > MaxEpicDistance )
+			continue;
 
+	/* The result of the station whose input & options are unchanged could be reused directly */
+		if ( store && (keyed = !build_result_key( &snl_infos[i], optkey, &reskey )) && !result_store_fetch( store, &snl_infos[i], reskey ) ) {
+			fprintf(stderr, "Reusing the stored result of %s.%s.%s!\n", snl_infos[i].meta->sta, snl_infos[i].meta->net, snl_infos[i].meta->loc);
+			continue;
+		}
+	/* The processed traces might be in the cache, then the loading & processing could be skipped */
+		identified = !container && CacheDir && CacheKey[0] && !postmajor_identify_station( &Context, &snl_infos[i], identity, sizeof(identity) );
+		cached     = identified && !trace_cache_load( CacheDir, CacheKey, identity, &snl_infos[i], traces );
+	/* */
+		if ( !cached && postmajor_load_station( &Context, &snl_infos[i] ) < 0 ) {
+			if ( store && keyed )
+				result_store_put( store, &snl_infos[i], reskey );
+			continue;
+		}
 	/* */
-		if ( LoadSeisdataFunc( &snl_infos[i], SeisDataFile ) < 0 ) {
-			init_snl_info_params( &snl_infos[i] );
+		if ( container ) {
+			if ( write_pmevent_station( container, &snl_infos[i] ) < 0 ) {
+				pmevent_writer_close( container );
+				return -1;
+			}
 			continue;
 		}
 
 	/* */
 		fprintf(
-			stderr, "Processing data of %s.%s.%s (start at %lf, npts %d, delta %.2lf)... \n",
-			snl_infos[i].sta, snl_infos[i].net, snl_infos[i].loc, snl_infos[i].starttime, snl_infos[i].npts, snl_infos[i].delta
+			stderr, "Processing %s of %s.%s.%s (start at %lf, npts %d, delta %.2lf)... \n",
+			cached ? "cached traces" : "data", snl_infos[i].meta->sta, snl_infos[i].meta->net, snl_infos[i].meta->loc,
+			snl_infos[i].state->starttime, snl_infos[i].state->npts, snl_infos[i].state->delta
 		);
 
 	/* Set the time before origin time 1 sec. as the start point for scaning */
-		if ( !( snl_infos[i].pick_flag = pick_pwave_arrival( &snl_infos[i], otime )) ) {
-		/* */
-			if ( snl_infos[i].parrival_pos > snl_infos[i].npts )
-				snl_infos[i].parrival_pos = 0;
-			fprintf(
-				stderr, "Can't find valid P arrival (Np: %d, SNR: %lf), skip those time related parameters for SNL %s.%s.%s.\n",
-				snl_infos[i].parrival_pos, snl_infos[i].snr, snl_infos[i].sta, snl_infos[i].net, snl_infos[i].loc
-			);
+		if ( !cached )
+			postmajor_pick_station( &Context, &snl_infos[i] );
+	/* The station without valid picking won't be output, skip all the processing, but the rerun could skip it directly */
+		if ( !is_output_snl( &snl_infos[i] ) ) {
+			trace_cache_free( traces );
+			postmajor_snl_free( &snl_infos[i] );
+			if ( store && keyed )
+				result_store_put( store, &snl_infos[i], reskey );
+			continue;
+		}
+	/* Fork the processing chains of all the configurations from the shared acceleration */
+		if ( conf_infos ) {
+			proc_configurations( &snl_infos[i], conf_infos + (size_t)i * NumProcConfigs );
+			postmajor_snl_free( &snl_infos[i] );
+			continue;
 		}
 	/* */
-		if ( (end_pos = snl_infos[i].parrival_pos + (int)(EV_DURATION / snl_infos[i].delta) + 1) > snl_infos[i].npts )
-			end_pos = snl_infos[i].npts;
+		end_pos = postmajor_proc_station( &Context, &snl_infos[i], cached, identified || sweep ? traces : NULL );
+		if ( !cached && identified )
+			trace_cache_store( CacheDir, CacheKey, identity, &snl_infos[i], traces );
+	/* The lead times of all the threshold combinations from the kept traces */
+		if ( sweep )
+			proc_sweep( &snl_infos[i], end_pos, traces, sweep + (size_t)i * nsweep );
+		trace_cache_free( traces );
 	/* */
-		snl_infos[i].sum_vel = calloc(snl_infos[i].npts, sizeof(float));
-		snl_infos[i].sum_dis = calloc(snl_infos[i].npts, sizeof(float));
-	/* First of all, process the raw acceleration sample */
-		proc_acc( &snl_infos[i], end_pos );
-	/* Fork the process depends on the two stage integral switch */
-		if ( TwoStageIntegral ) {
-		/* Transform the acceleration sample to velocity sample */
-			integral_waveforms( &snl_infos[i], true );
-		/* */
-			proc_vel( &snl_infos[i], end_pos );
-		/* Transform the velocity sample to displacement sample */
-			integral_waveforms( &snl_infos[i], true );
-		/* */
-			proc_disp( &snl_infos[i], end_pos );
-		}
-		else {
-		/* Transform the acceleration sample directly to displacement sample */
-			integral_waveforms( &snl_infos[i], false );
-			integral_waveforms( &snl_infos[i], true );
-		/* */
-			proc_disp( &snl_infos[i], end_pos );
-		/* Then transform the displacement sample back to velocity sample */
-			differential_waveform( &snl_infos[i] );
-		/* */
-			proc_vel( &snl_infos[i], end_pos );
-		}
-	/* Computation of Tau-c at 3 seconds */
-		snl_infos[i].tc = calc_tau_c(
-			&snl_infos[i].sum_dis[snl_infos[i].parrival_pos],
-			&snl_infos[i].sum_vel[snl_infos[i].parrival_pos],
-			end_pos, snl_infos[i].delta, 3
-		);
-	/* Finally, derive the lead time information */
-		proc_leadtime( &snl_infos[i] );
+		if ( store && keyed )
+			result_store_put( store, &snl_infos[i], reskey );
 
 	/* End of seismic data processing */
 		fprintf(
 			stderr, "Finished the processing data of %s.%s.%s (start at %lf, npts %d, delta %.2lf)!\n",
-			snl_infos[i].sta, snl_infos[i].net, snl_infos[i].loc, snl_infos[i].starttime, snl_infos[i].npts, snl_infos[i].delta
+			snl_infos[i].meta->sta, snl_infos[i].meta->net, snl_infos[i].meta->loc, snl_infos[i].state->starttime, snl_infos[i].state->npts, snl_infos[i].state->delta
 		);
 
 	/* After the processing, free the seismic data memory space */
-		for ( register int j = 0; j < NUM_CHANNEL_SNL; j++ ) {
-			if ( snl_infos[i].seis[j] ) {
-				free(snl_infos[i].seis[j]);
-				snl_infos[i].seis[j] = NULL;
-			}
-		}
-	/* */
-		if ( snl_infos[i].sum_vel )
-			free(snl_infos[i].sum_vel);
-		if ( snl_infos[i].sum_dis )
-			free(snl_infos[i].sum_dis);
+		postmajor_snl_free( &snl_infos[i] );
 	}
+/* */
+	if ( StreamOutput && !container )
+		stream_station_rows( snl_infos, conf_infos, sweep, nsweep, order[totalsnl - 1] );
 
-/* Output the result, first the header... */
-	if ( HeaderSwitch ) {
-		fprintf(stdout, OUTPUT_FILE_HEADER);
-		if ( CoordinateSwitch )
-			fprintf(stdout, OUTPUT_FILE_COOR_HEADER);
-		fprintf(stdout, "\n");
+/* */
+	if ( container ) {
+		postmajor_context_release( &Context );
+		free_snl_table( &snl_table );
+		free(snl_metas);
+		free(order);
+		return pmevent_writer_close( container ) < 0 ? -1 : 0;
 	}
-/* Then, all the stations' result */
-	for ( register int i = 0; i < totalsnl; i++ ) {
-	/* */
-		if ( (IgnStaWithoutData && snl_infos[i].npts < 0) || (IgnStaWithoutPick && !snl_infos[i].pick_flag) )
-			continue;
-	/* */
-		fprintf(
-			stdout, OUTPUT_DATA_FORMAT,
-			snl_infos[i].sta, snl_infos[i].net, snl_infos[i].loc,
-			snl_infos[i].pga, snl_infos[i].pgv, snl_infos[i].pgd,
-			snl_infos[i].pa3, snl_infos[i].pv3, snl_infos[i].pd3, snl_infos[i].tc,
-			snl_infos[i].pga_leadtime, snl_infos[i].pgv_leadtime, snl_infos[i].na_leadtime,
-			snl_infos[i].epic_dist, snl_infos[i].snr
-		);
-		if ( CoordinateSwitch )
-			fprintf(
-				stdout, OUTPUT_DATA_COOR_FORMAT,
-				snl_infos[i].latitude, snl_infos[i].longitude, snl_infos[i].elevation
-			);
-		fprintf(stdout, "\n");
+/* */
+	if ( store && result_store_close( store, ResultStoreFile ) < 0 )
+		fprintf(stderr, "WARNING! The results of this run are not stored!\n");
+/* Output the result in the station list order when it is not streamed */
+	if ( !StreamOutput ) {
+		output_header( stdout, conf_infos != NULL, sweep != NULL, false );
+	/* The results of each configuration are tagged */
+		if ( conf_infos ) {
+			for ( register int c = 0; c < NumProcConfigs; c++ ) {
+				for ( register int i = 0; i < totalsnl; i++ ) {
+					const SNL_INFO *result = snl_infos[i].state->npts < 0 ? &snl_infos[i] : &conf_infos[(size_t)i * NumProcConfigs + c];
+
+					if ( !is_output_snl( result ) )
+						continue;
+					output_snl_result( stdout, result );
+					fprintf(stdout, OUTPUT_DATA_CONF_FORMAT "\n", ProcConfigs[c].tag);
+				}
+			}
+		}
+	/* Then, all the stations' result or the lead time table of the sweep */
+		else {
+			for ( register int i = 0; i < totalsnl; i++ )
+				output_station_rows( stdout, &snl_infos[i], NULL, sweep ? sweep + (size_t)i * nsweep : NULL );
+		}
 	}
 
 /* */
-	ReleaseSeisdataFunc();
-	free(snl_infos);
+	postmajor_context_release( &Context );
+	free_snl_table( &snl_table );
+	free_snl_table( &conf_table );
+	free(snl_metas);
+	free(sweep);
+	free(order);
 
 	return 0;
 }
@@ -223,8 +385,8 @@ int main( int argc, char **argv )
  */
 static int proc_argv( int argc, char *argv[] )
 {
-	char informat[16] = { 0 };
-
+/* */
+	postmajor_context_init( &Context );
 	for ( register int i = 1; i < argc; i++ ) {
 		if ( !strcmp(argv[i], "-v") ) {
 			fprintf(stdout, "%s\n", PROG_NAME);
@@ -240,14 +402,29 @@ static int proc_argv( int argc, char *argv[] )
 		else if ( !strcmp(argv[i], "-c") ) {
 			CoordinateSwitch = true;
 		}
+		else if ( !strcmp(argv[i], "-u") ) {
+			StreamOutput = true;
+		}
+		else if ( !strcmp(argv[i], "-a") ) {
+			SequenceSwitch = true;
+		}
+		else if ( !strcmp(argv[i], "-b") ) {
+			BatchOutputDir = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-j") ) {
+			if ( (NumWorkers = atoi(argv[++i])) <= 0 ) {
+				fprintf(stderr, "Invalid number of workers: %s\n", argv[i]);
+				return -1;
+			}
+		}
 		else if ( !strcmp(argv[i], "-n") ) {
 			HeaderSwitch = false;
 		}
 		else if ( !strcmp(argv[i], "-t") ) {
-			TwoStageIntegral = true;
+			Context.two_stage = true;
 		}
 		else if ( !strcmp(argv[i], "-s") ) {
-			VecSumSwitch = true;
+			Context.vec_sum = true;
 		}
 		else if ( !strcmp(argv[i], "-i") ) {
 			IgnStaWithoutData = true;
@@ -255,9 +432,43 @@ static int proc_argv( int argc, char *argv[] )
 		else if ( !strcmp(argv[i], "-ip") ) {
 			IgnStaWithoutPick = true;
 		}
+		else if ( !strcmp(argv[i], "-d") ) {
+			if ( (MaxEpicDistance = atof(argv[++i])) <= 0.0 ) {
+				fprintf(stderr, "Invalid maximum epicentral distance: %s\n", argv[i]);
+				return -1;
+			}
+		}
+		else if ( !strcmp(argv[i], "-x") ) {
+			seisdata_ms_index_enable( &Context.loader );
+		}
+		else if ( !strcmp(argv[i], "-w") ) {
+			ContainerFile = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-C") ) {
+			CacheDir = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-R") ) {
+			ResultStoreFile = argv[++i];
+		}
+		else if ( !strcmp(argv[i], "-M") ) {
+			if ( (Context.metrics = parse_metrics( argv[++i] )) <= 0 )
+				return -1;
+		}
+		else if ( !strcmp(argv[i], "-m") ) {
+			if ( parse_configurations( argv[++i] ) < 0 )
+				return -1;
+		}
+		else if ( !strcmp(argv[i], "-pga") ) {
+			if ( parse_threshold_spec( argv[++i], &SweepPGAThresholds, &SweepNumPGA ) < 0 )
+				return -1;
+		}
+		else if ( !strcmp(argv[i], "-pd") ) {
+			if ( parse_threshold_spec( argv[++i], &SweepPdThresholds, &SweepNumPd ) < 0 )
+				return -1;
+		}
 		else if ( !strcmp(argv[i], "-f") ) {
-			strncpy(informat, argv[++i], sizeof(informat) - 1);
-			for ( char *c = informat; *c; c++ )
+			strncpy(InputFormat, argv[++i], sizeof(InputFormat) - 1);
+			for ( char *c = InputFormat; *c; c++ )
 				*c = toupper(*c);
 		}
 		else if ( i == argc - 1 ) {
@@ -281,25 +492,20 @@ static int proc_argv( int argc, char *argv[] )
 		return -1;
 	}
 /* */
-	if ( !strlen(informat) ) {
-		strcpy(informat, "SAC");
+	if ( !strlen(InputFormat) ) {
+		strcpy(InputFormat, "SAC");
 	}
 /* */
-	if ( !strcmp(informat, "SAC") ) {
-		LoadSeisdataFunc = seisdata_load_sac;
-		ReleaseSeisdataFunc = seisdata_release_sac;
-	}
-	else if ( !strcmp(informat, "MSEED") || !strcmp(informat, "MSEED3") ) {
-		LoadSeisdataFunc = seisdata_load_ms;
-		ReleaseSeisdataFunc = seisdata_release_ms;
-	}
-	else if ( !strcmp(informat, "TANK") ) {
-		LoadSeisdataFunc = seisdata_load_tank;
-		ReleaseSeisdataFunc = seisdata_release_tank;
-	}
-	else {
-		fprintf(stderr, "Unknown format: %s\n", informat);
+	if ( postmajor_context_input( &Context, InputFormat, SeisDataFile ) < 0 )
 		return -1;
+/* Only one of the thresholds is swept, the other one is just the default */
+	if ( SweepNumPGA && !SweepNumPd ) {
+		SweepPdThresholds = (float *)malloc(sizeof(float));
+		SweepPdThresholds[SweepNumPd++] = Context.pd_warn_threshold;
+	}
+	else if ( SweepNumPd && !SweepNumPGA ) {
+		SweepPGAThresholds = (float *)malloc(sizeof(float));
+		SweepPGAThresholds[SweepNumPGA++] = Context.pga_warn_threshold;
 	}
 
 	return 0;
@@ -324,11 +530,42 @@ static void usage( void )
 		" -h              Show this usage message\n"
 		" -c              Append the station coordinate in output, default is off\n"
 		" -n              Turn off the output header, default is on\n"
+		" -u              Stream out the result of each station once it is done, the stations are processed\n"
+		"                 from the closest one to the epicenter, default is output in the station list order\n"
 		" -t              Turn on the two stage integral process, default is only one stage\n"
 		" -s              Turn on the vector summation process, default is off\n"
 		" -i              Ignore the station without input seismic data, default is on\n"
 		" -ip             Ignore the station without valid picking, default is on\n"
-		" -f format       Specify input format, there are SAC, MSEED|MSEED3 & TANK, default is SAC\n"
+		" -d distance     Only process the stations within the maximum epicentral distance (km), the others\n"
+		"                 won't be loaded & output, default is off\n"
+		" -f format       Specify input format, there are SAC, MSEED|MSEED3, TANK, SDS & PME, default is SAC\n"
+		" -x              Load miniSEED thru the record index '<input seismic data>.idx' (built when absent),\n"
+		"                 only the records in the event window will be read, default is off\n"
+		" -w container    Convert the input seismic data into the event container (PME format) & exit,\n"
+		"                 the container can be processed later with '-f PME'\n"
+		" -C cache_dir    Keep the picked & processed traces of each station in the cache directory, the rerun\n"
+		"                 with the same input & processing parameters will skip to the peak value extraction\n"
+		" -m configs      Process with multiple configurations sharing the loading & picking, a list of\n"
+		"                 '1' (one stage), '2' (two stage) with optional 's' (vector summation), e.g. '1,1s,2,2s',\n"
+		"                 the results are tagged by the configuration in the last column\n"
+		" -M metrics      Only compute the selected metrics, a list of 'pga', 'pgv', 'pgd', 'pa3', 'pv3', 'pd3',\n"
+		"                 'tc' & 'lt' (lead times), the unneeded stages are skipped & the others are output as nan.\n"
+		"                 Without any of the peak values & lead times, only a few seconds after P will be processed\n"
+		" -pga thresholds Sweep the PGA warning thresholds, a list 'a,b,c' or a range 'start:stop:step',\n"
+		"                 the lead time table of all the combinations with '-pd' will be output instead\n"
+		" -pd thresholds  Sweep the Pd warning thresholds, same as '-pga'\n"
+		" -R result_store Reuse the stored results of the stations whose input files & options are unchanged,\n"
+		"                 only the others will be computed & then merged into the store\n"
+		" -b output_dir   Batch mode, the eq. info is a catalog of events, one per line with an optional last\n"
+		"                 column of the event's own input seismic data. The result of each event is written\n"
+		"                 into '<output_dir>/<index>_<YYYYmmdd_HHMMSS>.txt' & the events with the result are\n"
+		"                 skipped, so the interrupted run resumes where it stopped\n"
+		" -j workers      Number of the worker threads in the batch mode, default is the number of processors;\n"
+		"                 each worker loads its own copy of the input, so the memory grows with the workers\n"
+		" -a              All the events of the eq. info are within the input seismic data, e.g. the aftershock\n"
+		"                 sequence of one continuous record. Each station is loaded once, then the window of\n"
+		"                 each event is demeaned, integrated, picked & processed on its own; the results of each\n"
+		"                 event are output in turn & tagged by the event index in the last column\n"
 		//" -o output_file  Specify output file name, it will turn off the standard output & create a new output file\n"
 		"\n"
 		"This program will program to read SAC data files and compute\n"
@@ -343,54 +580,11 @@ static void usage( void )
 /**
  * @brief
  *
- * @param snl_info
- */
-static void init_snl_info_params( SNL_INFO *snl_info )
-{
-/* */
-	snl_info->npts         = -1;
-	snl_info->delta        = -1.0;
-	snl_info->starttime    = -1.0;
-	snl_info->pick_flag    = 0;
-	snl_info->parrival_pos = -1;
-	snl_info->sarrival_pos = -1;
-	snl_info->snr          = 0.0;
-/* Derived from waveform */
-	snl_info->pga = 0.0;
-	snl_info->pgv = 0.0;
-	snl_info->pgd = 0.0;
-	snl_info->pa3 = 0.0;
-	snl_info->pv3 = 0.0;
-	snl_info->pd3 = 0.0;
-	snl_info->tc  = 0.0;
-	snl_info->pd  = 0.0;
-/* */
-	snl_info->sum_vel = NULL;
-	snl_info->sum_dis = NULL;
-/* */
-	snl_info->pga_pos   = -1;
-	snl_info->pgv_pos   = -1;
-	snl_info->pgd_pos   = -1;
-/* */
-	snl_info->pd_warn_pos   = -1;
-	snl_info->pga_warn_pos  = -1;
-	snl_info->pga_watch_pos = -1;
-/* */
-	snl_info->pga_leadtime = NAN;
-	snl_info->pgv_leadtime = NAN;
-	snl_info->na_leadtime  = NAN;
-
-	return;
-}
-
-/**
- * @brief
- *
- * @param snl_info
+ * @param snl_meta
  * @param line
  * @return int
  */
-static int parse_stalist_line( SNL_INFO *snl_info, const char *line )
+static int parse_stalist_line( SNL_META *snl_meta, const char *line )
 {
 /* */
 	if ( strlen(line) ) {
@@ -404,8 +598,8 @@ static int parse_stalist_line( SNL_INFO *snl_info, const char *line )
 			else if (
 				sscanf(
 					line, "%s %s %s %f %f %f %s %e %s %e %s %e\n",
-					snl_info->sta, snl_info->net, snl_info->loc, &snl_info->latitude, &snl_info->longitude, &snl_info->elevation,
-					snl_info->chan[0], &snl_info->gain[0], snl_info->chan[1], &snl_info->gain[1], snl_info->chan[2], &snl_info->gain[2]
+					snl_meta->sta, snl_meta->net, snl_meta->loc, &snl_meta->latitude, &snl_meta->longitude, &snl_meta->elevation,
+					snl_meta->chan[0], &snl_meta->gain[0], snl_meta->chan[1], &snl_meta->gain[1], snl_meta->chan[2], &snl_meta->gain[2]
 				) == 12
 			) {
 					return 1;
@@ -421,16 +615,26 @@ static int parse_stalist_line( SNL_INFO *snl_info, const char *line )
 /**
  * @brief
  *
- * @param snl_info
+ * @param snl_meta
  * @param path
  * @return int
  */
-static int parse_stalist( SNL_INFO **snl_info, const char *path )
+static int parse_stalist( SNL_META **snl_meta, const char *path )
 {
-	FILE *fd = NULL;
-	char  line[MAX_STR_SIZE] = { 0 };
-	int   totalline = 0;
+	FILE  *fd = NULL;
+	STADB *db = NULL;
+	char   line[MAX_STR_SIZE] = { 0 };
+	int    totalline = 0;
 
+/* The compiled station database is just mapped, the broken one shouldn't be parsed as the text list */
+	if ( (totalline = stadb_open( path, &db )) < -1 )
+		return -1;
+	if ( !totalline ) {
+		totalline = load_stadb( snl_meta, db );
+		stadb_close( db );
+		return totalline;
+	}
+	totalline = 0;
 /* */
 	if ( (fd = fopen(path, "r")) == (FILE *)NULL ) {
 		fprintf(stderr, "Error opening station list %s\n", path);
@@ -438,22 +642,22 @@ static int parse_stalist( SNL_INFO **snl_info, const char *path )
 	}
 
 /* */
-	if ( !(*snl_info = (SNL_INFO *)calloc(1, sizeof(SNL_INFO))) ) {
+	if ( !(*snl_meta = (SNL_META *)calloc(1, sizeof(SNL_META))) ) {
 		fprintf(stderr, "Error allocating memory space for SNLs!\n");
 		totalline = -1;
 		goto close_list;
 	}
 /* */
 	while ( fgets(line, sizeof(line) - 1, fd) != NULL )
-		if ( parse_stalist_line( *snl_info, line ) )
+		if ( parse_stalist_line( *snl_meta, line ) )
 			totalline++;
 /* */
 	rewind(fd);
 
 /* */
 	if ( totalline > 1 ) {
-		free(*snl_info);
-		if ( !(*snl_info = (SNL_INFO *)calloc(totalline + 1, sizeof(SNL_INFO))) ) {
+		free(*snl_meta);
+		if ( !(*snl_meta = (SNL_META *)calloc(totalline + 1, sizeof(SNL_META))) ) {
 			fprintf(stderr, "Error allocating memory space for SNLs!\n");
 			totalline = -1;
 			goto close_list;
@@ -462,11 +666,15 @@ static int parse_stalist( SNL_INFO **snl_info, const char *path )
 /* */
 	totalline = 0;
 	while ( fgets(line, sizeof(line) - 1, fd) != NULL ) {
-		memset(*snl_info + totalline, 0 , sizeof(SNL_INFO));
-		init_snl_info_params( *snl_info + totalline );
-		if ( parse_stalist_line( *snl_info + totalline, line ) )
+		memset(*snl_meta + totalline, 0 , sizeof(SNL_META));
+		if ( parse_stalist_line( *snl_meta + totalline, line ) )
 			totalline++;
 	}
+/* The records of the channel listed twice would be released by the first loading, so all of them are kept */
+	if ( has_duplicate_channels( *snl_meta, totalline ) ) {
+		fprintf(stderr, "WARNING! Some channels are listed more than once, all the loaded input will be kept in memory!\n");
+		seisdata_keep_input_enable( &Context.loader );
+	}
 
 close_list:
 	fclose(fd);
@@ -474,506 +682,1002 @@ close_list:
 	return totalline;
 }
 
-/*
+/**
+ * @brief Copy the stations of the mapped database into the SNL list, there is nothing to parse.
  *
+ * @param snl_meta
+ * @param db
+ * @return int
  */
-static int parse_eqinfo_file( const char *path, float *epc_lat, float *epc_lon, float *dep, double *otime )
+static int load_stadb( SNL_META **snl_meta, const STADB *db )
 {
-	FILE *fd;
-	char  line[MAX_STR_SIZE] = { 0 };
-/* */
-	float year;
-	float mon;
-	float day;
-	float hour;
-	float min;
-	float sec;
-	struct tm _otime;
+	const uint32_t nstations = db->header->nstations;
 
 /* */
-	if ( (fd = fopen(path, "r")) == (FILE *)NULL ) {
-		fprintf(stderr, "Error opening Eq. information %s\n", path);
-		return -2;
+	if ( !(*snl_meta = (SNL_META *)calloc(nstations + 1, sizeof(SNL_META))) ) {
+		fprintf(stderr, "Error allocating memory space for SNLs!\n");
+		return -1;
 	}
 /* */
-	while ( fgets(line, sizeof(line) - 1, fd) != NULL ) {
-	/* */
-		if ( strlen(line) ) {
-			for ( register int i = 0; i < MAX_STR_SIZE; i++ ) {
-				if ( line[i] == '#' || line[i] == '\n' ) {
-					break;
-				}
-				else if ( line[i] == '\t' || line[i] == ' ' ) {
-					continue;
-				}
-				else if (
-					sscanf(
-						line, "%f %f %f %f %f %f %f %f %f\n",
-						&year, &mon, &day, &hour, &min, &sec, epc_lat, epc_lon, dep
-					) == 9
-				) {
-				/* Keep the column of second to zero, then add it back after converting */
-					_otime.tm_year  = (int)year - 1900;
-					_otime.tm_mon   = (int)mon - 1;
-					_otime.tm_mday  = (int)day;
-					_otime.tm_hour  = (int)hour;
-					_otime.tm_min   = (int)min;
-					_otime.tm_sec   = 0;
-					_otime.tm_isdst = 0;
-				/* If we do so, we can have fraction of second */
-					*dep    = -(*dep);
-					*otime  = (double)timegm(&_otime);
-					*otime += sec;
-
-					fclose(fd);
-					return 0;
-				}
-			/* */
-				break;
-			}
+	for ( register uint32_t i = 0; i < nstations; i++ ) {
+		const STADB_STATION *station = &db->stations[i];
+		SNL_META            *_snl    = *snl_meta + i;
+
+		strncpy(_snl->sta, station->sta, K_LEN);
+		strncpy(_snl->net, station->net, K_LEN);
+		strncpy(_snl->loc, station->loc, K_LEN);
+		for ( register int j = 0; j < NUM_CHANNEL_SNL; j++ ) {
+			strncpy(_snl->chan[j], station->chan[j], K_LEN);
+			_snl->gain[j] = station->gain[j];
 		}
+		_snl->latitude  = station->latitude;
+		_snl->longitude = station->longitude;
+		_snl->elevation = station->elevation;
+	}
+
+	return (int)nstations;
+}
+
+/**
+ * @brief Check if any channel of the SNL list is listed more than once, the compiled database is already unique.
+ *
+ * @param snl_meta
+ * @param nstations
+ * @return _Bool
+ */
+static _Bool has_duplicate_channels( const SNL_META *snl_meta, const int nstations )
+{
+	const size_t total  = (size_t)nstations * NUM_CHANNEL_SNL;
+	_Bool        result = false;
+	SNL_CHANNEL *chans  = NULL;
+
+/* */
+	if ( total < 2 || !(chans = (SNL_CHANNEL *)malloc(total * sizeof(SNL_CHANNEL))) )
+		return false;
+	for ( register size_t i = 0; i < total; i++ ) {
+		chans[i].meta = snl_meta + i / NUM_CHANNEL_SNL;
+		chans[i].chan = i % NUM_CHANNEL_SNL;
 	}
+	qsort(chans, total, sizeof(SNL_CHANNEL), compare_channels);
 /* */
-	fclose(fd);
-	return -1;
+	for ( register size_t i = 1; i < total && !result; i++ )
+		result = !compare_channels( &chans[i - 1], &chans[i] );
+	free(chans);
+
+	return result;
 }
 
 /**
  * @brief
  *
- * @param snl_info
- * @param origin_time
+ * @param a
+ * @param b
  * @return int
  */
-static int pick_pwave_arrival( SNL_INFO *snl_info, const double origin_time )
+static int compare_channels( const void *a, const void *b )
 {
-	int start_pick = (int)((origin_time - snl_info->starttime) / snl_info->delta);
+	const SNL_CHANNEL *_a = (const SNL_CHANNEL *)a;
+	const SNL_CHANNEL *_b = (const SNL_CHANNEL *)b;
+	int                result;
 
 /* */
-	if ( start_pick < 0 )
-		start_pick = 0;
+	if (
+		(result = strcmp(_a->meta->sta, _b->meta->sta)) || (result = strcmp(_a->meta->net, _b->meta->net)) ||
+		(result = strcmp(_a->meta->loc, _b->meta->loc))
+	) {
+		return result;
+	}
+
+	return strcmp(_a->meta->chan[_a->chan], _b->meta->chan[_b->chan]);
+}
+
+/**
+ * @brief Allocate the state & result arrays over the station metadata, each station has the given number of
+ *        copies, e.g. one for each configuration, & all of them share the same metadata.
+ *
+ * @param table
+ * @param snl_metas
+ * @param nstations
+ * @param copies
+ * @return int
+ */
+static int alloc_snl_table( SNL_TABLE *table, SNL_META *snl_metas, const int nstations, const int copies )
+{
+	const size_t total = (size_t)nstations * copies;
+
 /* */
-	snl_info->snr = 0.0;
-	if ( (snl_info->parrival_pos = pickwu_p_arrival_pick( snl_info->seis[0], snl_info->npts, snl_info->delta, 2, start_pick )) ) {
-		if ( pickwu_p_trigger_check( snl_info->seis[0], snl_info->npts, snl_info->delta, snl_info->parrival_pos ) ) {
-			if ( pickwu_p_arrival_quality_calc( snl_info->seis[0], snl_info->npts, snl_info->delta, snl_info->parrival_pos, &snl_info->snr ) < 4 ) {
-				return 1;
-			}
-		}
+	memset(table, 0, sizeof(SNL_TABLE));
+	table->nstations = nstations;
+	table->metas     = snl_metas;
+	if (
+		!(table->states = (SNL_STATE *)calloc(total, sizeof(SNL_STATE))) ||
+		!(table->results = (SNL_RESULT *)calloc(total, sizeof(SNL_RESULT))) ||
+		!(table->infos = (SNL_INFO *)calloc(total, sizeof(SNL_INFO)))
+	) {
+		fprintf(stderr, "ERROR! Out of memory for the station table!\n");
+		free_snl_table( table );
+		return -1;
 	}
 /* */
-	snl_info->parrival_pos = start_pick;
+	for ( register size_t i = 0; i < total; i++ ) {
+		table->infos[i].meta   = &snl_metas[i / copies];
+		table->infos[i].state  = &table->states[i];
+		table->infos[i].result = &table->results[i];
+		postmajor_snl_init( &table->infos[i] );
+	}
 
 	return 0;
 }
 
 /**
- * @brief
+ * @brief Release the state & result arrays of the table, the metadata is owned by the caller.
  *
- * @param snl_info
- * @param end_pos
+ * @param table
  */
-static void proc_acc( SNL_INFO *snl_info, const int end_pos )
+static void free_snl_table( SNL_TABLE *table )
 {
-	float vec_sum[snl_info->npts];
+	free(table->states);
+	free(table->results);
+	free(table->infos);
+	memset(table, 0, sizeof(SNL_TABLE));
+
+	return;
+}
+
+/*
+ *
+ */
+static int parse_eqinfo_file( const char *path, float *epc_lat, float *epc_lon, float *dep, double *otime )
+{
+	FILE         *fd;
+	char          line[MAX_STR_SIZE] = { 0 };
+	CATALOG_EVENT event;
 
 /* */
-	snl_info->pga_warn_pos = snl_info->pga_watch_pos = end_pos;
-/* */
-	if ( VecSumSwitch ) {
-		for ( register int j = snl_info->parrival_pos; j < end_pos; j++ ) {
-			vec_sum[j] =
-				snl_info->seis[0][j] * snl_info->seis[0][j] +
-				snl_info->seis[1][j] * snl_info->seis[1][j] +
-				snl_info->seis[2][j] * snl_info->seis[2][j];
-			vec_sum[j] = sqrtf(vec_sum[j]);
-		/* */
-			if ( vec_sum[j] > PGAWatchThreshold ) {
-			/* */
-				if ( j < snl_info->pga_watch_pos )
-					snl_info->pga_watch_pos = j;
-			/* */
-				if ( vec_sum[j] > PGAWarnThreshold ) {
-					if ( j < snl_info->pga_warn_pos )
-						snl_info->pga_warn_pos = j;
-				}
-			}
-		/* */
-			if ( vec_sum[j] > snl_info->pga ) {
-				snl_info->pga     = vec_sum[j];
-				snl_info->pga_pos = j;
-			}
+	if ( (fd = fopen(path, "r")) == (FILE *)NULL ) {
+		fprintf(stderr, "Error opening Eq. information %s\n", path);
+		return -2;
+	}
+/* Only the first event is used, the same line format as the catalog */
+	while ( fgets(line, sizeof(line) - 1, fd) != NULL ) {
+		if ( !catalog_parse_line( line, &event ) ) {
+			*epc_lat = event.latitude;
+			*epc_lon = event.longitude;
+			*dep     = event.depth;
+			*otime   = event.origin_time;
+
+			fclose(fd);
+			return 0;
 		}
-	/* */
-		snl_info->pa3 = calc_peak_value( &vec_sum[snl_info->parrival_pos], end_pos, snl_info->delta, 3 );
 	}
-	else {
+/* */
+	fclose(fd);
+	return -1;
+}
+
+/**
+ * @brief Fork the processing chain of each configuration from the shared acceleration of the picked station.
+ *
+ * @param snl_info
+ * @param results
+ */
+static void proc_configurations( const SNL_INFO *snl_info, SNL_INFO *results )
+{
+	POSTMAJOR_CONTEXT ctx = Context;
+
+/* Each configuration is just a copy of the context with its own integral & summation */
+	for ( register int c = 0; c < NumProcConfigs; c++ ) {
+		*results[c].state  = *snl_info->state;
+		*results[c].result = *snl_info->result;
 		for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
-			for ( register int j = snl_info->parrival_pos; j < end_pos; j++ ) {
-			/* */
-				if ( fabs(snl_info->seis[i][j]) > PGAWatchThreshold ) {
-				/* */
-					if ( j < snl_info->pga_watch_pos )
-						snl_info->pga_watch_pos = j;
-				/* */
-					if ( fabs(snl_info->seis[i][j]) > PGAWarnThreshold ) {
-						if ( j < snl_info->pga_warn_pos )
-							snl_info->pga_warn_pos = j;
-					}
-				}
-			/* */
-				if ( fabs(snl_info->seis[i][j]) > snl_info->pga ) {
-					snl_info->pga     = fabs(snl_info->seis[i][j]);
-					snl_info->pga_pos = j;
-				}
-			}
+			if ( (results[c].state->seis[i] = (float *)malloc(snl_info->state->npts * sizeof(float))) )
+				memcpy(results[c].state->seis[i], snl_info->state->seis[i], snl_info->state->npts * sizeof(float));
 		}
 	/* */
-		snl_info->pa3 = calc_peak_value( snl_info->seis[0] + snl_info->parrival_pos, end_pos, snl_info->delta, 3 );
+		if ( results[c].state->seis[0] && results[c].state->seis[1] && results[c].state->seis[2] ) {
+			ctx.two_stage = ProcConfigs[c].two_stage;
+			ctx.vec_sum   = ProcConfigs[c].vec_sum;
+			postmajor_proc_station( &ctx, &results[c], false, NULL );
+		}
+		else {
+			fprintf(stderr, "ERROR! Out of memory for the configuration %s of %s.%s.%s!\n", ProcConfigs[c].tag, snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc);
+		}
+		postmajor_snl_free( &results[c] );
 	}
 
-
 	return;
 }
 
 /**
- * @brief
+ * @brief Derive the lead times of all the combinations of PGA & Pd warning thresholds in one pass. The running
+ *        maximum of the acceleration & displacement are built once, then the first crossing position of each
+ *        threshold is just a binary search on it.
  *
  * @param snl_info
  * @param end_pos
+ * @param traces
+ * @param table
  */
-static void proc_vel( SNL_INFO *snl_info, const int end_pos )
-{
-	float vec_sum[snl_info->npts];
+static void proc_sweep(
+	const SNL_INFO *snl_info, const int end_pos, float * const traces[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL], float *table
+) {
+	float * const *acc = traces[TRACE_CACHE_ACC];
+	float * const *dis = traces[TRACE_CACHE_DISP];
+	float          acc_max[snl_info->state->npts];
+	float          pd_max[snl_info->state->npts];
+	float          value;
+	int            pga_warn_pos;
+	int            pd_warn_pos;
 
 /* */
-	if ( VecSumSwitch ) {
-		for ( register int j = snl_info->parrival_pos; j < end_pos; j++ ) {
-			vec_sum[j] =
-				snl_info->seis[0][j] * snl_info->seis[0][j] +
-				snl_info->seis[1][j] * snl_info->seis[1][j] +
-				snl_info->seis[2][j] * snl_info->seis[2][j];
-		/* */
-			snl_info->sum_vel[j] = vec_sum[j] + snl_info->sum_vel[j > 0 ? j - 1 : 0];
-		/* */
-			vec_sum[j] = sqrtf(vec_sum[j]);
-		/* */
-			if ( vec_sum[j] > snl_info->pgv ) {
-				snl_info->pgv     = vec_sum[j];
-				snl_info->pgv_pos = j;
-			}
+	if ( !snl_info->result->pick_flag || !acc[0] || !dis[0] ) {
+		for ( register int i = 0; i < SweepNumPGA * SweepNumPd * 3; i++ )
+			table[i] = NAN;
+		return;
+	}
+/* Build the running maximum, the same measurement as the processing of acceleration & displacement */
+	for ( register int j = snl_info->state->parrival_pos; j < end_pos; j++ ) {
+		if ( Context.vec_sum ) {
+			value = sqrtf(acc[0][j] * acc[0][j] + acc[1][j] * acc[1][j] + acc[2][j] * acc[2][j]);
 		}
+		else {
+			value = fabs(acc[0][j]);
+			for ( register int i = 1; i < NUM_CHANNEL_SNL; i++ )
+				if ( fabs(acc[i][j]) > value )
+					value = fabs(acc[i][j]);
+		}
+		acc_max[j] = j > snl_info->state->parrival_pos && acc_max[j - 1] > value ? acc_max[j - 1] : value;
 	/* */
-		snl_info->pv3 = calc_peak_value( &vec_sum[snl_info->parrival_pos], end_pos, snl_info->delta, 3 );
+		if ( Context.vec_sum )
+			value = sqrtf(dis[0][j] * dis[0][j] + dis[1][j] * dis[1][j] + dis[2][j] * dis[2][j]);
+		else
+			value = fabs(dis[0][j]);
+		pd_max[j] = j > snl_info->state->parrival_pos && pd_max[j - 1] > value ? pd_max[j - 1] : value;
 	}
-	else {
-		for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
-			for ( register int j = snl_info->parrival_pos; j < end_pos; j++ ) {
-			/* */
-				if ( fabs(snl_info->seis[i][j]) > snl_info->pgv ) {
-					snl_info->pgv     = fabs(snl_info->seis[i][j]);
-					snl_info->pgv_pos = j;
-				}
-			}
+/* The warning of PGA also needs the watch threshold */
+	for ( register int i = 0; i < SweepNumPGA; i++ ) {
+		pga_warn_pos = first_crossing(
+			acc_max, snl_info->state->parrival_pos, end_pos,
+			SweepPGAThresholds[i] > Context.pga_watch_threshold ? SweepPGAThresholds[i] : Context.pga_watch_threshold
+		);
+		for ( register int j = 0; j < SweepNumPd; j++, table += 3 ) {
+			pd_warn_pos = first_crossing( pd_max, snl_info->state->parrival_pos, end_pos, SweepPdThresholds[j] );
+			table[0] = table[1] = table[2] = NAN;
+			if ( pd_warn_pos > 0 || pga_warn_pos > 0 )
+				postmajor_derive_leadtime( snl_info, SweepPGAThresholds[i], SweepPdThresholds[j], pga_warn_pos, pd_warn_pos, &table[0], &table[1], &table[2] );
 		}
-	/* */
-		for ( register int i = snl_info->parrival_pos; i < end_pos; i++ )
-			snl_info->sum_vel[i] = snl_info->seis[0][i] * snl_info->seis[0][i] + snl_info->sum_vel[i > 0 ? i - 1 : 0];
-	/* */
-		snl_info->pv3 = calc_peak_value( snl_info->seis[0] + snl_info->parrival_pos, end_pos, snl_info->delta, 3 );
 	}
 
 	return;
 }
 
 /**
- * @brief
+ * @brief Find the first position where the running maximum exceeds the threshold, the end position when never.
  *
- * @param snl_info
- * @param end_pos
+ * @param running_max
+ * @param start
+ * @param end
+ * @param threshold
+ * @return int
  */
-static void proc_disp( SNL_INFO *snl_info, const int end_pos )
+static int first_crossing( const float *running_max, const int start, const int end, const float threshold )
 {
-	float vec_sum[snl_info->npts];
+	int lower = start;
+	int upper = end;
+	int middle;
 
 /* */
-	snl_info->pd_warn_pos = end_pos;
+	while ( lower < upper ) {
+		middle = lower + (upper - lower) / 2;
+		if ( running_max[middle] > threshold )
+			upper = middle;
+		else
+			lower = middle + 1;
+	}
+
+	return lower;
+}
+
+/**
+ * @brief Parse the thresholds from the list 'a,b,c' or the range 'start:stop:step'.
+ *
+ * @param spec
+ * @param thresholds
+ * @param count
+ * @return int
+ */
+static int parse_threshold_spec( const char *spec, float **thresholds, int *count )
+{
+	double start;
+	double stop;
+	double step;
+	int    _count = 1;
+	float *_thresholds = NULL;
+
 /* */
-	if ( VecSumSwitch ) {
-		for ( register int j = snl_info->parrival_pos; j < end_pos; j++ ) {
-			vec_sum[j] =
-				snl_info->seis[0][j] * snl_info->seis[0][j] +
-				snl_info->seis[1][j] * snl_info->seis[1][j] +
-				snl_info->seis[2][j] * snl_info->seis[2][j];
-		/* */
-			snl_info->sum_dis[j] = vec_sum[j] + snl_info->sum_dis[j > 0 ? j - 1 : 0];
-		/* */
-			vec_sum[j] = sqrtf(vec_sum[j]);
-		/* */
-			if ( vec_sum[j] > PdWarnThreshold ) {
-				if ( j < snl_info->pd_warn_pos )
-					snl_info->pd_warn_pos = j;
-			}
-		/* */
-			if ( vec_sum[j] > snl_info->pgd ) {
-				snl_info->pgd     = vec_sum[j];
-				snl_info->pgd_pos = j;
-			}
+	if ( sscanf(spec, "%lf:%lf:%lf", &start, &stop, &step) == 3 ) {
+		if ( step <= 0.0 || stop < start || (_count = (int)((stop - start) / step + 1.0e-6) + 1) > MAX_SWEEP_THRESHOLDS ) {
+			fprintf(stderr, "Invalid threshold range: %s\n", spec);
+			return -1;
 		}
-	/* Computation of Pd at 3 seconds */
-		snl_info->pd3 = calc_peak_value( &vec_sum[snl_info->parrival_pos], end_pos, snl_info->delta, 3 );
+		if ( !(_thresholds = (float *)malloc(_count * sizeof(float))) )
+			return -1;
+		for ( register int i = 0; i < _count; i++ )
+			_thresholds[i] = start + i * step;
 	}
 	else {
-	/* */
-		for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
-			for ( register int j = snl_info->parrival_pos; j < end_pos; j++ ) {
-			/* */
-				if ( i == 0 ) {
-					if ( fabs(snl_info->seis[i][j]) > snl_info->pd )
-						snl_info->pd = fabs(snl_info->seis[i][j]);
-					if ( fabs(snl_info->seis[i][j]) > PdWarnThreshold && j < snl_info->pd_warn_pos )
-						snl_info->pd_warn_pos = j;
-				}
-			/* */
-				if ( fabs(snl_info->seis[i][j]) > snl_info->pgd ) {
-					snl_info->pgd     = fabs(snl_info->seis[i][j]);
-					snl_info->pgd_pos = j;
-				}
+		for ( const char *c = spec; *c; c++ )
+			if ( *c == ',' )
+				_count++;
+		if ( _count > MAX_SWEEP_THRESHOLDS || !(_thresholds = (float *)malloc(_count * sizeof(float))) )
+			return -1;
+		_count = 0;
+		for ( const char *c = spec; c; c = strchr(c, ',') ? strchr(c, ',') + 1 : NULL ) {
+			char *end = NULL;
+
+			_thresholds[_count] = strtod(c, &end);
+			if ( end == c || (*end && *end != ',') ) {
+				fprintf(stderr, "Invalid threshold list: %s\n", spec);
+				free(_thresholds);
+				return -1;
 			}
+			_count++;
 		}
-	/* */
-		for ( register int i = snl_info->parrival_pos; i < end_pos; i++ )
-			snl_info->sum_dis[i] = snl_info->seis[0][i] * snl_info->seis[0][i] + snl_info->sum_dis[i > 0 ? i - 1 : 0];
-	/* Computation of Pd at 3 seconds */
-		snl_info->pd3 = calc_peak_value( snl_info->seis[0] + snl_info->parrival_pos, end_pos, snl_info->delta, 3 );
 	}
+/* */
+	free(*thresholds);
+	*thresholds = _thresholds;
+	*count      = _count;
 
-	return;
+	return 0;
 }
 
 /**
- * @brief
+ * @brief Write the loaded & preprocessed channels of the station into the event container, then free them.
  *
+ * @param container
  * @param snl_info
+ * @return int
  */
-static void proc_leadtime( SNL_INFO *snl_info )
+static int write_pmevent_station( PMEVENT_WRITER *container, SNL_INFO *snl_info )
 {
+	PMEVENT_STATION station;
+	int             result = 0;
+
 /* */
-	if ( !snl_info->pick_flag || (snl_info->pd_warn_pos <= 0 && snl_info->pga_warn_pos <= 0) ) {
-		snl_info->na_leadtime = snl_info->pga_leadtime = snl_info->pgv_leadtime = NAN;
-	/* Reset the P-wave peak value 'cause there is not valid arrival time */
-		if ( !snl_info->pick_flag )
-			snl_info->pa3 = snl_info->pv3 = snl_info->pd3 = snl_info->tc = 0.0;
+	memset(&station, 0, sizeof(station));
+	strncpy(station.sta, snl_info->meta->sta, PMEVENT_CODE_LEN);
+	strncpy(station.net, snl_info->meta->net, PMEVENT_CODE_LEN);
+	strncpy(station.loc, snl_info->meta->loc, PMEVENT_CODE_LEN);
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		strncpy(station.chan[i], snl_info->meta->chan[i], PMEVENT_CODE_LEN);
+		station.gain[i] = snl_info->meta->gain[i];
 	}
-	else {
-	/* */
-		if ( (snl_info->pga_pos - snl_info->pd_warn_pos) <= (snl_info->pga_pos - snl_info->pga_warn_pos) )
-			snl_info->pga_leadtime = (snl_info->pga_pos - snl_info->pga_warn_pos) * snl_info->delta;
-		else
-			snl_info->pga_leadtime = (snl_info->pga_pos - snl_info->pd_warn_pos) * snl_info->delta;
-	/* */
-		if ( (snl_info->pgv_pos - snl_info->pd_warn_pos) <= (snl_info->pgv_pos - snl_info->pga_warn_pos) )
-			snl_info->pgv_leadtime = (snl_info->pgv_pos - snl_info->pga_warn_pos) * snl_info->delta;
-		else
-			snl_info->pgv_leadtime = (snl_info->pgv_pos - snl_info->pd_warn_pos) * snl_info->delta;
-	/* */
-		if ( snl_info->pga >= PGAWarnThreshold && snl_info->pd >= PdWarnThreshold )
-			snl_info->na_leadtime = (snl_info->pga_warn_pos - snl_info->pd_warn_pos) * snl_info->delta;
-		else if ( snl_info->pd >= PdWarnThreshold )
-			snl_info->na_leadtime = -1.0;
-	/* */
-		if ( snl_info->na_leadtime < 0.0 )
-			snl_info->na_leadtime = NAN;
-		if ( snl_info->pga_leadtime < 0.0 )
-			snl_info->pga_leadtime = NAN;
-		if ( snl_info->pgv_leadtime < 0.0 )
-			snl_info->pgv_leadtime = NAN;
+	station.npts      = snl_info->state->npts;
+	station.starttime = snl_info->state->starttime;
+	station.delta     = snl_info->state->delta;
+/* */
+	fprintf(
+		stderr, "Writing data of %s.%s.%s (start at %lf, npts %d, delta %.2lf) into the container...\n",
+		snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, snl_info->state->starttime, snl_info->state->npts, snl_info->state->delta
+	);
+	result = pmevent_writer_append( container, &station, snl_info->state->seis );
+/* */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		free(snl_info->state->seis[i]);
+		snl_info->state->seis[i] = NULL;
 	}
 
-	return;
+	return result;
 }
 
 /**
- * @brief
+ * @brief Build the result key of the station from the option key, the station parameters & the identity of
+ *        its input files.
  *
  * @param snl_info
- * @param filter_sw
+ * @param optkey
+ * @param key
+ * @return int
  */
-static void integral_waveforms( SNL_INFO *snl_info, const _Bool filter_sw )
+static int build_result_key( const SNL_INFO *snl_info, const char *optkey, uint64_t *key )
 {
-	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ )
-		_integral_waveform( snl_info->seis[i], snl_info->npts, snl_info->delta, filter_sw );
+	char stakey[RESULT_STORE_KEY_LEN];
+	int  len;
 
-	return;
+/* */
+	len = snprintf(
+		stakey, sizeof(stakey), "%s|%s.%s.%s|%.6f|%.6f|%.2f", optkey,
+		snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, snl_info->meta->latitude, snl_info->meta->longitude, snl_info->meta->elevation
+	);
+	for ( register int i = 0; i < NUM_CHANNEL_SNL && len < (int)sizeof(stakey); i++ )
+		len += snprintf(stakey + len, sizeof(stakey) - len, "|%s:%.9g", snl_info->meta->chan[i], snl_info->meta->gain[i]);
+	if ( len >= (int)sizeof(stakey) || postmajor_identify_station( &Context, snl_info, stakey + len, sizeof(stakey) - len ) < 0 )
+		return -1;
+/* */
+	*key = result_store_key( stakey );
+
+	return 0;
 }
 
 /**
- * @brief
+ * @brief Parse the list of configurations, e.g. '1,1s,2,2s'.
+ *
+ * @param spec
+ * @return int
+ */
+static int parse_configurations( const char *spec )
+{
+	NumProcConfigs = 0;
+	for ( const char *c = spec; c; c = strchr(c, ',') ? strchr(c, ',') + 1 : NULL ) {
+		const size_t len = strchr(c, ',') ? (size_t)(strchr(c, ',') - c) : strlen(c);
+
+	/* */
+		if ( NumProcConfigs >= MAX_PROC_CONFIGS || (len != 1 && len != 2) || (c[0] != '1' && c[0] != '2') || (len == 2 && c[1] != 's') ) {
+			fprintf(stderr, "Invalid configuration list: %s\n", spec);
+			return -1;
+		}
+		ProcConfigs[NumProcConfigs].two_stage = c[0] == '2';
+		ProcConfigs[NumProcConfigs].vec_sum   = len == 2;
+		memcpy(ProcConfigs[NumProcConfigs].tag, c, len);
+		ProcConfigs[NumProcConfigs].tag[len] = '\0';
+		NumProcConfigs++;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Output the result of the station without the line end.
  *
+ * @param fp
  * @param snl_info
  */
-static void differential_waveform( SNL_INFO *snl_info )
+static void output_snl_result( FILE *fp, const SNL_INFO *snl_info )
 {
-	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ )
-		_differential_waveform( snl_info->seis[i], snl_info->npts, snl_info->delta );
+	fprintf(
+		fp, OUTPUT_DATA_FORMAT,
+		snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc,
+		snl_info->result->pga, snl_info->result->pgv, snl_info->result->pgd,
+		snl_info->result->pa3, snl_info->result->pv3, snl_info->result->pd3, snl_info->result->tc,
+		snl_info->result->pga_leadtime, snl_info->result->pgv_leadtime, snl_info->result->na_leadtime,
+		snl_info->result->epic_dist, snl_info->result->snr
+	);
+	if ( CoordinateSwitch )
+		fprintf(
+			fp, OUTPUT_DATA_COOR_FORMAT,
+			snl_info->meta->latitude, snl_info->meta->longitude, snl_info->meta->elevation
+		);
 
 	return;
 }
 
 /**
- * @brief
+ * @brief Parse the list of selected metrics, e.g. 'pd3,tc'.
  *
- * @param input
- * @param npts
- * @param delta
- * @param filter_sw
- * @return float*
+ * @param spec
+ * @return int
  */
-static float *_integral_waveform( float *input, const int npts, const double delta, const _Bool filter_sw )
+static int parse_metrics( const char *spec )
 {
-	const float half_delta = delta * 0.5;
+	static const struct {
+		const char *name;
+		int         metric;
+	} metrics[] = {
+		{ "pga", METRIC_PGA }, { "pgv", METRIC_PGV }, { "pgd", METRIC_PGD },
+		{ "pa3", METRIC_PA3 }, { "pv3", METRIC_PV3 }, { "pd3", METRIC_PD3 },
+		{ "tc", METRIC_TC }, { "lt", METRIC_LEADTIME }
+	};
 
-	register float last_seis  = 0.0;
-	register float this_pseis = 0.0;
+	int result = 0;
 
 /* */
-	for ( register int i = 0; i < npts; i++ ) {
-		this_pseis = (input[i] + last_seis) * half_delta + this_pseis;
-		last_seis  = input[i];
-		input[i]   = this_pseis;
+	for ( const char *c = spec; c; c = strchr(c, ',') ? strchr(c, ',') + 1 : NULL ) {
+		const size_t len    = strchr(c, ',') ? (size_t)(strchr(c, ',') - c) : strlen(c);
+		int          metric = 0;
+
+		for ( register size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]) && !metric; i++ )
+			if ( strlen(metrics[i].name) == len && !strncmp(c, metrics[i].name, len) )
+				metric = metrics[i].metric;
+	/* */
+		if ( !metric ) {
+			fprintf(stderr, "Invalid metric list: %s\n", spec);
+			return -1;
+		}
+		result |= metric;
 	}
-/* */
-	if ( filter_sw )
-		highpass_filter( input, npts, delta, false );
 
-	return input;
+	return result;
 }
 
 /**
- * @brief
+ * @brief Derive the epicentral distances of the stations thru the station index, only the stations within
+ *        the maximum distance are visited & the others are set to infinity. The order of processing, from
+ *        the closest station, is also derived; the stations not visited are appended in the list order.
+ *        The number of visited stations is returned.
  *
- * @param input
- * @param npts
- * @param delta
- * @return float*
+ * @param index
+ * @param table
+ * @param elon
+ * @param elat
+ * @param order
+ * @return int
  */
-static float *_differential_waveform( float *input, const int npts, const double delta )
+static int derive_epic_dists( const STATION_INDEX *index, const SNL_TABLE *table, const double elon, const double elat, int *order )
 {
-	register float last_seis  = 0.0;
-	register float this_pseis = 0.0;
+	const int totalsnl = table->nstations;
+	double   *dists    = NULL;
+	_Bool    *visited  = NULL;
+	int       count    = -1;
 
 /* */
-	for ( register int i = 0; i < npts; i++ ) {
-		this_pseis = (input[i] - last_seis) / delta;
-		last_seis  = input[i];
-		input[i]   = this_pseis;
+	if ( (dists = (double *)malloc(totalsnl * sizeof(double))) && (visited = (_Bool *)calloc(totalsnl, sizeof(_Bool))) )
+		count = station_index_radius( index, elon, elat, MaxEpicDistance > 0.0 ? MaxEpicDistance : INFINITY, order, dists );
+	else
+		fprintf(stderr, "ERROR! Out of memory for the epicentral distances!\n");
+/* */
+	if ( count >= 0 ) {
+		for ( register int i = 0; i < totalsnl; i++ )
+			table->results[i].epic_dist = MaxEpicDistance > 0.0 ? INFINITY : NAN;
+		for ( register int i = 0; i < count; i++ ) {
+			table->results[order[i]].epic_dist = dists[i];
+			visited[order[i]] = true;
+		}
+		for ( register int i = 0, j = count; i < totalsnl; i++ )
+			if ( !visited[i] )
+				order[j++] = i;
 	}
+/* */
+	free(dists);
+	free(visited);
 
-	return input;
+	return count;
+}
+
+/**
+ * @brief Check the output filters of the station, i.e. the data, the picking & the epicentral distance.
+ *
+ * @param snl_info
+ * @return _Bool
+ */
+static _Bool is_output_snl( const SNL_INFO *snl_info )
+{
+	if ( IgnStaWithoutData && snl_info->state->npts < 0 )
+		return false;
+	if ( IgnStaWithoutPick && !snl_info->result->pick_flag )
+		return false;
+	if ( MaxEpicDistance > 0.0 && snl_info->result->epic_dist > MaxEpicDistance )
+		return false;
+
+	return true;
 }
 
 /**
  * @brief
  *
- * @param input
- * @param npts
- * @param delta
- * @param zero_phase
- * @return float*
+ * @param fp
+ * @param conf
+ * @param sweep
+ * @param event
  */
-static float *highpass_filter( float *input, const int npts, const double delta, const _Bool zero_phase )
+static void output_header( FILE *fp, const _Bool conf, const _Bool sweep, const _Bool event )
 {
-	IIR_FILTER filter;
-	IIR_STAGE *stage;
+	if ( !HeaderSwitch )
+		return;
+/* */
+	if ( sweep ) {
+		fprintf(fp, OUTPUT_SWEEP_HEADER "\n");
+	}
+	else {
+		fprintf(fp, OUTPUT_FILE_HEADER);
+		if ( CoordinateSwitch )
+			fprintf(fp, OUTPUT_FILE_COOR_HEADER);
+		if ( conf )
+			fprintf(fp, OUTPUT_FILE_CONF_HEADER);
+		if ( event )
+			fprintf(fp, OUTPUT_FILE_EVENT_HEADER);
+		fprintf(fp, "\n");
+	}
 
-	filter = iirfilter_design( 2, IIR_HIGHPASS_FILTER, IIR_BUTTERWORTH, 0.075, 0.0, delta );
-	stage  = (IIR_STAGE *)calloc(filter.nsects, sizeof(IIR_STAGE));
+	return;
+}
 
-/* First time, forward filtering */
-	memset(stage, 0, sizeof(IIR_STAGE) * filter.nsects);
-	for ( register int i = 0; i < npts; i++ )
-		input[i] = iirfilter_apply( input[i], &filter, stage );
-/* Second time, backward filtering */
-	if ( zero_phase ) {
-		memset(stage, 0, sizeof(IIR_STAGE) * filter.nsects);
-		for ( register int i = npts - 1; i >= 0; i-- )
-			input[i] = iirfilter_apply( input[i], &filter, stage );
+/**
+ * @brief Output all the rows of the station, i.e. the result of each configuration, the lead time table of
+ *        the sweep or just the result.
+ *
+ * @param fp
+ * @param snl_info
+ * @param conf_infos
+ * @param table
+ */
+static void output_station_rows( FILE *fp, const SNL_INFO *snl_info, const SNL_INFO *conf_infos, const float *table )
+{
+/* */
+	if ( conf_infos ) {
+		for ( register int c = 0; c < NumProcConfigs; c++ ) {
+			const SNL_INFO *result = snl_info->state->npts < 0 ? snl_info : &conf_infos[c];
+
+			if ( !is_output_snl( result ) )
+				continue;
+			output_snl_result( fp, result );
+			fprintf(fp, OUTPUT_DATA_CONF_FORMAT "\n", ProcConfigs[c].tag);
+		}
+		return;
 	}
 /* */
-	free(stage);
+	if ( !is_output_snl( snl_info ) )
+		return;
+	if ( table ) {
+		for ( register int j = 0; j < SweepNumPGA; j++ ) {
+			for ( register int k = 0; k < SweepNumPd; k++ ) {
+				const float *row = table + (j * SweepNumPd + k) * 3;
+
+				fprintf(
+					fp, OUTPUT_SWEEP_FORMAT "\n", snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc,
+					SweepPGAThresholds[j], SweepPdThresholds[k], row[1], row[2], row[0]
+				);
+			}
+		}
+	}
+	else {
+		output_snl_result( fp, snl_info );
+		fprintf(fp, "\n");
+	}
 
-	return input;
+	return;
 }
 
 /**
- * @brief
+ * @brief Stream out the rows of the station right after its processing.
+ *
+ * @param snl_infos
+ * @param conf_infos
+ * @param sweep
+ * @param nsweep
+ * @param index
+ */
+static void stream_station_rows(
+	const SNL_INFO *snl_infos, const SNL_INFO *conf_infos, const float *sweep, const int nsweep, const int index
+) {
+	output_station_rows(
+		stdout, &snl_infos[index],
+		conf_infos ? conf_infos + (size_t)index * NumProcConfigs : NULL,
+		sweep ? sweep + (size_t)index * nsweep : NULL
+	);
+	fflush(stdout);
+
+	return;
+}
+
+/**
+ * @brief Process all the events of the catalog by the workers. The station list is parsed & indexed once for
+ *        all the events & each worker keeps its own input loaded, only the events without result are processed.
+ *        The loaders unpack the records into their trace lists, so they can't be shared between the workers &
+ *        the peak memory is about one loaded input per worker.
  *
- * @param sum_dis
- * @param sum_vel
- * @param npts
- * @param delta
- * @param sec
- * @return float
+ * @return int
  */
-static float calc_tau_c( const float *sum_dis, const float *sum_vel, const int npts, const float delta, const int sec )
+static int proc_catalog( void )
 {
-	const int i_end = (int)(sec / delta);
+	const CATALOG_HANDLERS handlers = { open_catalog_event, proc_catalog_station, close_catalog_event };
+
+	CATALOG_EVENT *events   = NULL;
+	BATCH_SHARED   shared   = { 0 };
+	char           path[MAX_STR_SIZE];
+	int            nevents  = 0;
+	int            npending = 0;
+	int            failed   = 0;
+
+/* These options only work for a single event */
+	if ( StreamOutput || ContainerFile || CacheDir || ResultStoreFile || NumProcConfigs || SweepNumPGA ) {
+		fprintf(stderr, "WARNING! The streaming, the container, the trace cache, the result store, the configurations & the sweep are disabled for the batch mode!\n");
+		StreamOutput    = false;
+		ContainerFile   = CacheDir = ResultStoreFile = NULL;
+		NumProcConfigs  = SweepNumPGA = SweepNumPd = 0;
+	}
+/* The records fetched from the index only cover the window of one event */
+	if ( Context.loader.ms_index_switch ) {
+		fprintf(stderr, "WARNING! The record index is disabled for the batch mode, the whole miniSEED will be kept for all the events!\n");
+		Context.loader.ms_index_switch = false;
+	}
+/* The standard input can only be read by one worker */
+	if ( !strcmp(SeisDataFile, "-") )
+		NumWorkers = 1;
+	else if ( !NumWorkers && (NumWorkers = (int)sysconf(_SC_NPROCESSORS_ONLN)) <= 0 )
+		NumWorkers = 1;
+/* */
+	if ( access(BatchOutputDir, W_OK) ) {
+		fprintf(stderr, "ERROR! Cannot write the results into the output directory %s!\n", BatchOutputDir);
+		return -1;
+	}
+	if ( (nevents = catalog_parse( EqInfoFile, &events )) <= 0 )
+		return -1;
+	if ( (shared.nstations = parse_stalist( &shared.metas, StaListFile )) <= 0 )
+		return -1;
+	if ( !(shared.index = station_index_build( shared.metas, shared.nstations )) )
+		return -1;
 
-	float result = 0.0;
+/* The event with the result had been finished by the previous run */
+	for ( register int i = 0; i < nevents; i++ ) {
+		if ( catalog_result_path( BatchOutputDir, &events[i], path, sizeof(path) ) < 0 ) {
+			fprintf(stderr, "ERROR! The result path of the event %d within %s is too long!\n", events[i].index, BatchOutputDir);
+			return -1;
+		}
+		if ( access(path, F_OK) )
+			events[npending++] = events[i];
+	}
+	if ( npending < nevents )
+		fprintf(stderr, "Skipping %d finished events of the catalog, %d events are left...\n", nevents - npending, npending);
+/* Each worker has its own context, the input shared by the events is kept after loading */
+	if ( !(shared.contexts = (POSTMAJOR_CONTEXT *)malloc(NumWorkers * sizeof(POSTMAJOR_CONTEXT))) ) {
+		fprintf(stderr, "ERROR! Out of memory for the workers!\n");
+		return -1;
+	}
+	for ( register int i = 0; i < NumWorkers; i++ ) {
+		shared.contexts[i] = Context;
+		seisdata_keep_input_enable( &shared.contexts[i].loader );
+	}
+	fprintf(stderr, "Processing %d events of the catalog with %d workers...\n", npending, NumWorkers);
+	failed = catalog_schedule( events, npending, NumWorkers, &handlers, &shared );
 
 /* */
-	if ( i_end < npts )
-		result = PI2 * sqrt(sum_dis[i_end] / sum_vel[i_end]);
+	for ( register int i = 0; i < NumWorkers; i++ )
+		postmajor_context_release( &shared.contexts[i] );
+	station_index_free( shared.index );
+	free(shared.contexts);
+	free(shared.metas);
+	free(events);
+/* The failed events have no result, so they will be processed again by the rerun */
+	if ( failed ) {
+		fprintf(stderr, "WARNING! %d events of the catalog are failed, rerun to process them again!\n", failed);
+		return -1;
+	}
 
-	return result > 10.0 ? 10.0 : result;
+	return 0;
 }
 
 /**
- * @brief
+ * @brief Open the event of the catalog, the epicentral distances are derived thru the shared station index.
+ *        Only the stations within the maximum distance are the tasks of the event.
  *
- * @param input
- * @param npts
- * @param delta
- * @param sec
- * @return float
+ * @param event
+ * @param ntasks
+ * @param arg
+ * @return void*
  */
-static float calc_peak_value( const float *input, const int npts, const float delta, const int sec )
+static void *open_catalog_event( const CATALOG_EVENT *event, int *ntasks, void *arg )
 {
-	const int i_end = (int)(sec / delta);
+	const BATCH_SHARED *shared = (const BATCH_SHARED *)arg;
+	BATCH_EVENT        *result = NULL;
+
+/* */
+	if (
+		!(result = (BATCH_EVENT *)calloc(1, sizeof(BATCH_EVENT))) ||
+		!(result->order = (int *)malloc(shared->nstations * sizeof(int)))
+	) {
+		fprintf(stderr, "ERROR! Out of memory for the event %d of the catalog!\n", event->index);
+		free(result);
+		return NULL;
+	}
+	result->event = event;
+/* */
+	if (
+		alloc_snl_table( &result->table, shared->metas, shared->nstations, 1 ) < 0 ||
+		(*ntasks = derive_epic_dists( shared->index, &result->table, event->longitude, event->latitude, result->order )) < 0
+	) {
+		free_snl_table( &result->table );
+		free(result->order);
+		free(result);
+		return NULL;
+	}
 
-	register float result = 0.0;
+	return result;
+}
 
+/**
+ * @brief Process one station of the event by the context of the worker, the input of the context is only
+ *        switched when the event has its own input.
+ *
+ * @param state
+ * @param task
+ * @param worker
+ * @param arg
+ */
+static void proc_catalog_station( void *state, const int task, const int worker, void *arg )
+{
+	const BATCH_EVENT *batch    = (const BATCH_EVENT *)state;
+	POSTMAJOR_CONTEXT *ctx      = &((BATCH_SHARED *)arg)->contexts[worker];
+	SNL_INFO          *snl_info = &batch->table.infos[batch->order[task]];
+	const char        *input    = batch->event->input[0] ? batch->event->input : SeisDataFile;
+
+/* The station can't be loaded from the previous input, just like the loading failed */
+	if ( strcmp(ctx->path, input) ) {
+		postmajor_context_release( ctx );
+		if ( postmajor_context_input( ctx, InputFormat, input ) < 0 ) {
+			fprintf(stderr, "ERROR! Cannot switch to the input %s of the event %d!\n", input, batch->event->index);
+			postmajor_snl_init( snl_info );
+			return;
+		}
+	}
+	postmajor_context_event( ctx, batch->event->origin_time );
 /* */
-	if ( i_end > npts )
-		return 0.0;
+	if ( postmajor_load_station( ctx, snl_info ) < 0 )
+		return;
+	fprintf(
+		stderr, "Processing data of %s.%s.%s for the event %d (start at %lf, npts %d, delta %.2lf)... \n",
+		snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, batch->event->index,
+		snl_info->state->starttime, snl_info->state->npts, snl_info->state->delta
+	);
+/* The station without valid picking won't be output, skip all the processing */
+	postmajor_pick_station( ctx, snl_info );
+	if ( is_output_snl( snl_info ) )
+		postmajor_proc_station( ctx, snl_info, false, NULL );
+	postmajor_snl_free( snl_info );
 
-	for ( register int i = 1; i < i_end; i++ ) {
-	/* */
-		if ( fabs(input[i]) > result )
-			result = fabs(input[i]);
+	return;
+}
+
+/**
+ * @brief Write the result of the event in the station list order & release it. The result is written to a
+ *        temporary name & then renamed, so the existing result is always a finished event.
+ *
+ * @param state
+ * @param arg
+ * @return int
+ */
+static int close_catalog_event( void *state, void *arg )
+{
+	BATCH_EVENT *batch  = (BATCH_EVENT *)state;
+	FILE        *fp     = NULL;
+	char         path[MAX_STR_SIZE];
+	char         tmppath[MAX_STR_SIZE + 32];
+	int          result = 0;
+
+/* */
+	catalog_result_path( BatchOutputDir, batch->event, path, sizeof(path) );
+	snprintf(tmppath, sizeof(tmppath), "%s.%ld.tmp", path, (long)getpid());
+	if ( !(fp = fopen(tmppath, "w")) ) {
+		fprintf(stderr, "ERROR! Cannot create the result %s of the event %d!\n", tmppath, batch->event->index);
+		result = -2;
+	}
+	else {
+		_Bool failed;
+
+		output_header( fp, false, false, false );
+		for ( register int i = 0; i < batch->table.nstations; i++ )
+			output_station_rows( fp, &batch->table.infos[i], NULL, NULL );
+		failed = ferror(fp);
+		if ( fclose(fp) || failed || rename(tmppath, path) ) {
+			fprintf(stderr, "ERROR! Cannot write the result %s of the event %d!\n", path, batch->event->index);
+			remove(tmppath);
+			result = -2;
+		}
+		else {
+			fprintf(stderr, "Finished the event %d, the result is written into %s!\n", batch->event->index, path);
+		}
 	}
+/* */
+	free_snl_table( &batch->table );
+	free(batch->order);
+	free(batch);
 
 	return result;
 }
 
 /**
- * @brief  Transforms the coordinate(latitude & longitude) into distance(unit: km)
+ * @brief Process all the events of the eq. info within the same input seismic data, e.g. the aftershock sequence
+ *        of one continuous record. Each station is loaded only once, then the window of each event is cut out of
+ *        the record & processed as a single event.
  *
- * @param elon
- * @param elat
- * @param slon
- * @param slat
- * @return double
+ * @return int
  */
-static double coor2distf( const double elon, const double elat, const double slon, const double slat )
+static int proc_sequence( void )
 {
-	const double avlat = (elat + slat) * 0.5;
+	CATALOG_EVENT    *events    = NULL;
+	SNL_META         *snl_metas = NULL;
+	SNL_TABLE         snl_table = { 0 };
+	SNL_TABLE         ev_table  = { 0 };
+	STATION_INDEX    *index     = NULL;
+	int              *order     = NULL;
+	int               nevents   = 0;
+	int               totalsnl  = 0;
+	double            first     = INFINITY;
+	double            last      = -INFINITY;
+	POSTMAJOR_CONTEXT ctx;
+
+/* These options only work for a single event */
+	if ( StreamOutput || ContainerFile || CacheDir || ResultStoreFile || NumProcConfigs || SweepNumPGA ) {
+		fprintf(stderr, "WARNING! The streaming, the container, the trace cache, the result store, the configurations & the sweep are disabled for multiple events!\n");
+		StreamOutput    = false;
+		ContainerFile   = CacheDir = ResultStoreFile = NULL;
+		NumProcConfigs  = SweepNumPGA = SweepNumPd = 0;
+	}
+/* */
+	if ( (nevents = catalog_parse( EqInfoFile, &events )) <= 0 )
+		return -1;
+	if ( (totalsnl = parse_stalist( &snl_metas, StaListFile )) <= 0 )
+		return -1;
+	if ( alloc_snl_table( &snl_table, snl_metas, totalsnl, 1 ) < 0 || alloc_snl_table( &ev_table, snl_metas, totalsnl, nevents ) < 0 )
+		return -1;
+/* The epicentral distances of each event, they are kept in the results of the event */
+	if ( !(order = (int *)malloc(totalsnl * sizeof(int))) || !(index = station_index_build( snl_metas, totalsnl )) )
+		return -1;
+	for ( register int e = 0; e < nevents; e++ ) {
+		if ( derive_epic_dists( index, &snl_table, events[e].longitude, events[e].latitude, order ) < 0 )
+			return -1;
+		for ( register int i = 0; i < totalsnl; i++ )
+			ev_table.results[(size_t)i * nevents + e].epic_dist = snl_table.results[i].epic_dist;
+	/* */
+		if ( events[e].origin_time < first )
+			first = events[e].origin_time;
+		if ( events[e].origin_time > last )
+			last = events[e].origin_time;
+	}
+	station_index_free( index );
+	free(order);
+/* The loaders can skip the data outside of the windows of all the events */
+	seisdata_window_set( &Context.loader, first - EV_PRE_DURATION, last + EV_DURATION + EV_PRE_DURATION );
+	ctx = Context;
+
+/* */
+	for ( register int i = 0; i < totalsnl; i++ ) {
+		SNL_INFO *snl_info  = &snl_table.infos[i];
+		SNL_INFO *ev_infos  = ev_table.infos + (size_t)i * nevents;
+		int       e;
+
+	/* The station beyond the maximum distance of all the events won't be output, even the loading could be skipped */
+		for ( e = 0; e < nevents && MaxEpicDistance > 0.0 && ev_infos[e].result->epic_dist > MaxEpicDistance; e++ );
+		if ( e == nevents )
+			continue;
+	/* */
+		if ( postmajor_load_station( &Context, snl_info ) < 0 )
+			continue;
+		fprintf(
+			stderr, "Processing data of %s.%s.%s for %d events (start at %lf, npts %d, delta %.2lf)... \n",
+			snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, nevents,
+			snl_info->state->starttime, snl_info->state->npts, snl_info->state->delta
+		);
+	/* Only the loaded record is shared, each event is demeaned, integrated & filtered within its own window */
+		for ( e = 0; e < nevents; e++ ) {
+			if ( MaxEpicDistance > 0.0 && ev_infos[e].result->epic_dist > MaxEpicDistance )
+				continue;
+			postmajor_context_event( &ctx, events[e].origin_time );
+			if ( postmajor_slice_station( &ctx, snl_info, &ev_infos[e] ) < 0 )
+				continue;
+		/* */
+			postmajor_pick_station( &ctx, &ev_infos[e] );
+			if ( is_output_snl( &ev_infos[e] ) )
+				postmajor_proc_station( &ctx, &ev_infos[e], false, NULL );
+			postmajor_snl_free( &ev_infos[e] );
+		}
+	/* */
+		postmajor_snl_free( snl_info );
+		fprintf(
+			stderr, "Finished the processing data of %s.%s.%s for %d events!\n",
+			snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, nevents
+		);
+	}
 
-	double a = 1.840708 + avlat * (.0015269 + avlat * (-.00034 + avlat * (1.02337e-6)));
-	double b = 1.843404 + avlat * (-6.93799e-5 + avlat * (8.79993e-6 + avlat * (-6.47527e-8)));
+/* The results of each event are output in turn & tagged by the index of event */
+	output_header( stdout, false, false, true );
+	for ( register int e = 0; e < nevents; e++ ) {
+		for ( register int i = 0; i < totalsnl; i++ ) {
+			const SNL_INFO *result = &ev_table.infos[(size_t)i * nevents + e];
 
-	a *= (slon - elon) * 60.0;
-	b *= (slat - elat) * 60.0;
+			if ( !is_output_snl( result ) )
+				continue;
+			output_snl_result( stdout, result );
+			fprintf(stdout, OUTPUT_DATA_EVENT_FORMAT "\n", events[e].index);
+		}
+	}
 
-	return sqrt(a * a + b * b);
+/* */
+	postmajor_context_release( &Context );
+	free_snl_table( &snl_table );
+	free_snl_table( &ev_table );
+	free(snl_metas);
+	free(events);
+
+	return 0;
 }
@@ -0,0 +1,308 @@
+/**
+ * @file result_store.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Keep the per-station results of the previous runs. A row is only reused when the key, the hash
+ *        of the station's input identity & the whole option set, is the same, so the rerun for late
+ *        data just recomputes the stations whose inputs were changed & merges the others.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+/* */
+#include <postmajor.h>
+#include <result_store.h>
+
+/* */
+#define MAX_FILE_NAME  512
+/* */
+static RESULT_STORE_ROW *find_row( const RESULT_STORE *, const char *, const char *, const char * );
+static RESULT_STORE_ROW *append_row( RESULT_STORE *, const char *, const char *, const char * );
+static uint32_t          hash_snl( const char *, const char *, const char * );
+
+/**
+ * @brief Read all the rows of the store into memory, an empty store is created when the file is absent.
+ *
+ * @param path
+ * @return RESULT_STORE*
+ */
+RESULT_STORE *result_store_open( const char *path )
+{
+	RESULT_STORE       *result = NULL;
+	RESULT_STORE_ROW    row;
+	RESULT_STORE_HEADER header;
+	FILE               *fp = NULL;
+
+/* */
+	if ( !(result = (RESULT_STORE *)calloc(1, sizeof(RESULT_STORE))) ) {
+		fprintf(stderr, "ERROR! Out of memory for the result store!\n");
+		return NULL;
+	}
+	if ( !(fp = fopen(path, "rb")) ) {
+		if ( errno != ENOENT )
+			fprintf(stderr, "WARNING! Cannot open the result store %s, all the stations will be computed!\n", path);
+		return result;
+	}
+/* */
+	if (
+		fread(&header, sizeof(header), 1, fp) != 1 ||
+		memcmp(header.magic, RESULT_STORE_MAGIC, sizeof(header.magic)) || header.version != RESULT_STORE_VERSION
+	) {
+		fprintf(stderr, "WARNING! %s is not a valid result store, all the stations will be computed!\n", path);
+		fclose(fp);
+		return result;
+	}
+	for ( register uint32_t i = 0; i < header.nrows; i++ ) {
+		RESULT_STORE_ROW *_row = NULL;
+
+		if ( fread(&row, sizeof(row), 1, fp) != 1 ) {
+			fprintf(stderr, "WARNING! The result store %s is incomplete, only %u rows are read!\n", path, i);
+			break;
+		}
+	/* */
+		if ( !(_row = append_row( result, row.sta, row.net, row.loc )) )
+			break;
+		row.next = _row->next;
+		*_row    = row;
+	}
+	fclose(fp);
+
+	return result;
+}
+
+/**
+ * @brief FNV-1a hash of the key string of input identity & options.
+ *
+ * @param key
+ * @return uint64_t
+ */
+uint64_t result_store_key( const char *key )
+{
+	uint64_t result = 14695981039346656037ULL;
+
+/* */
+	for ( ; *key; key++ ) {
+		result ^= (uint8_t)*key;
+		result *= 1099511628211ULL;
+	}
+
+	return result;
+}
+
+/**
+ * @brief Fetch the result of the station when its key is unchanged.
+ *
+ * @param store
+ * @param snl_info
+ * @param key
+ * @return int
+ */
+int result_store_fetch( RESULT_STORE *store, SNL_INFO *snl_info, const uint64_t key )
+{
+	const RESULT_STORE_ROW *row = find_row( store, snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc );
+
+/* */
+	if ( !row || row->key != key )
+		return -1;
+/* */
+	snl_info->state->npts          = row->npts;
+	snl_info->result->pick_flag    = row->pick_flag;
+	snl_info->state->parrival_pos  = row->parrival_pos;
+	snl_info->state->delta         = row->delta;
+	snl_info->state->starttime     = row->starttime;
+	snl_info->result->snr          = row->snr;
+	snl_info->result->pga          = row->pga;
+	snl_info->result->pgv          = row->pgv;
+	snl_info->result->pgd          = row->pgd;
+	snl_info->result->pa3          = row->pa3;
+	snl_info->result->pv3          = row->pv3;
+	snl_info->result->pd3          = row->pd3;
+	snl_info->result->tc           = row->tc;
+	snl_info->state->pd            = row->pd;
+	snl_info->result->na_leadtime  = row->na_leadtime;
+	snl_info->result->pga_leadtime = row->pga_leadtime;
+	snl_info->result->pgv_leadtime = row->pgv_leadtime;
+
+	return 0;
+}
+
+/**
+ * @brief Put the result of the station into the store, the previous row of the station will be replaced.
+ *
+ * @param store
+ * @param snl_info
+ * @param key
+ * @return int
+ */
+int result_store_put( RESULT_STORE *store, const SNL_INFO *snl_info, const uint64_t key )
+{
+	RESULT_STORE_ROW *row = find_row( store, snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc );
+
+/* */
+	if ( !row && !(row = append_row( store, snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc )) )
+		return -2;
+/* */
+	row->key          = key;
+	row->npts         = snl_info->state->npts;
+	row->pick_flag    = snl_info->result->pick_flag;
+	row->parrival_pos = snl_info->state->parrival_pos;
+	row->delta        = snl_info->state->delta;
+	row->starttime    = snl_info->state->starttime;
+	row->snr          = snl_info->result->snr;
+	row->pga          = snl_info->result->pga;
+	row->pgv          = snl_info->result->pgv;
+	row->pgd          = snl_info->result->pgd;
+	row->pa3          = snl_info->result->pa3;
+	row->pv3          = snl_info->result->pv3;
+	row->pd3          = snl_info->result->pd3;
+	row->tc           = snl_info->result->tc;
+	row->pd           = snl_info->state->pd;
+	row->na_leadtime  = snl_info->result->na_leadtime;
+	row->pga_leadtime = snl_info->result->pga_leadtime;
+	row->pgv_leadtime = snl_info->result->pgv_leadtime;
+
+	return 0;
+}
+
+/**
+ * @brief Write all the rows back to the store & release it, the file is written to a temporary name & then renamed.
+ *
+ * @param store
+ * @param path
+ * @return int
+ */
+int result_store_close( RESULT_STORE *store, const char *path )
+{
+	char                tmppath[MAX_FILE_NAME + 32];
+	RESULT_STORE_HEADER header;
+	FILE               *fp     = NULL;
+	int                 result = 0;
+
+/* */
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, RESULT_STORE_MAGIC, sizeof(header.magic));
+	header.version = RESULT_STORE_VERSION;
+	header.nrows   = store->nrows;
+/* */
+	snprintf(tmppath, sizeof(tmppath), "%s.%ld.tmp", path, (long)getpid());
+	if ( !(fp = fopen(tmppath, "wb")) ) {
+		fprintf(stderr, "ERROR! Cannot create the result store %s!\n", tmppath);
+		result = -2;
+	}
+	else {
+		_Bool failed = fwrite(&header, sizeof(header), 1, fp) != 1;
+
+		if ( !failed && store->nrows )
+			failed = fwrite(store->rows, sizeof(RESULT_STORE_ROW), store->nrows, fp) != store->nrows;
+		if ( fclose(fp) || failed || rename(tmppath, path) ) {
+			fprintf(stderr, "ERROR! Cannot write the result store %s!\n", path);
+			remove(tmppath);
+			result = -2;
+		}
+	}
+/* */
+	free(store->rows);
+	free(store);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param store
+ * @param sta
+ * @param net
+ * @param loc
+ * @return RESULT_STORE_ROW*
+ */
+static RESULT_STORE_ROW *find_row( const RESULT_STORE *store, const char *sta, const char *net, const char *loc )
+{
+	RESULT_STORE_ROW *row = NULL;
+
+/* */
+	for ( uint32_t i = store->hash[hash_snl( sta, net, loc )]; i; i = row->next ) {
+		row = &store->rows[i - 1];
+		if (
+			!strncmp(row->sta, sta, RESULT_STORE_CODE_LEN) &&
+			!strncmp(row->net, net, RESULT_STORE_CODE_LEN) &&
+			!strncmp(row->loc, loc, RESULT_STORE_CODE_LEN)
+		) {
+			return row;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Append an empty row of the station & link it into the hash slot.
+ *
+ * @param store
+ * @param sta
+ * @param net
+ * @param loc
+ * @return RESULT_STORE_ROW*
+ */
+static RESULT_STORE_ROW *append_row( RESULT_STORE *store, const char *sta, const char *net, const char *loc )
+{
+	RESULT_STORE_ROW *result = NULL;
+	uint32_t          slot   = hash_snl( sta, net, loc );
+
+/* */
+	if ( store->nrows == store->capacity ) {
+		uint32_t          _capacity = store->capacity ? store->capacity * 2 : 256;
+		RESULT_STORE_ROW *_rows     = realloc(store->rows, _capacity * sizeof(RESULT_STORE_ROW));
+
+		if ( !_rows ) {
+			fprintf(stderr, "ERROR! Out of memory for the result store!\n");
+			return NULL;
+		}
+		store->rows     = _rows;
+		store->capacity = _capacity;
+	}
+/* */
+	result = &store->rows[store->nrows++];
+	memset(result, 0, sizeof(RESULT_STORE_ROW));
+	strncpy(result->sta, sta, RESULT_STORE_CODE_LEN);
+	strncpy(result->net, net, RESULT_STORE_CODE_LEN);
+	strncpy(result->loc, loc, RESULT_STORE_CODE_LEN);
+	result->next      = store->hash[slot];
+	store->hash[slot] = store->nrows;
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param sta
+ * @param net
+ * @param loc
+ * @return uint32_t
+ */
+static uint32_t hash_snl( const char *sta, const char *net, const char *loc )
+{
+	uint32_t result = 2166136261u;
+
+/* */
+	for ( int i = 0; i < RESULT_STORE_CODE_LEN && sta[i]; i++ )
+		result = (result ^ (uint8_t)sta[i]) * 16777619u;
+	result = (result ^ '.') * 16777619u;
+	for ( int i = 0; i < RESULT_STORE_CODE_LEN && net[i]; i++ )
+		result = (result ^ (uint8_t)net[i]) * 16777619u;
+	result = (result ^ '.') * 16777619u;
+	for ( int i = 0; i < RESULT_STORE_CODE_LEN && loc[i]; i++ )
+		result = (result ^ (uint8_t)loc[i]) * 16777619u;
+
+	return result % RESULT_STORE_HASH_SIZE;
+}
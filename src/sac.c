@@ -25,6 +25,7 @@
 
 /*  */
 static int    read_sac_header( FILE *, struct SAChead * );
+static int    check_sac_byteorder( struct SAChead *, const long );
 static double fetch_sac_time( const struct SAChead * );
 static char  *trim_sac_string( char *, const int );
 static void   swap_order_4byte( void * );
@@ -77,6 +78,44 @@ end_process:
 	return result;
 }
 
+/**
+ * @brief Load the SAC header & data from the memory buffer, e.g. the member of archive.
+ *
+ * @param buffer
+ * @param size
+ * @param sh
+ * @param seis
+ * @return int
+ */
+int sac_buffer_load( const void *buffer, const size_t size, struct SAChead *sh, float **seis )
+{
+	float *_seis = NULL;
+	int    i;
+
+/* */
+	if ( size < sizeof(struct SAChead) ) {
+		fprintf(stderr, "Error reading SAC buffer: too short (%zu bytes)!\n", size);
+		return -1;
+	}
+	memcpy(sh, buffer, sizeof(struct SAChead));
+	if ( (i = check_sac_byteorder( sh, (long)size )) < 0 )
+		return -1;
+/* */
+	if ( (_seis = (float *)malloc((size_t)(sh->npts * sizeof(float)))) == (float *)NULL ) {
+		fprintf(stderr, "ERROR! Out of memory for %d float samples\n", sh->npts);
+		return -2;
+	}
+	memcpy(_seis, (const char *)buffer + sizeof(struct SAChead), sh->npts * sizeof(float));
+/* */
+	if ( i == 1 )
+		for ( i = 0; i < sh->npts; i++ )
+			swap_order_4byte( _seis + i );
+/* */
+	*seis = _seis;
+
+	return sizeof(struct SAChead) + sh->npts * sizeof(float);
+}
+
 /**
  * @brief
  *
@@ -175,7 +214,7 @@ struct SAChead *sac_az_inc_modify( struct SAChead *sh, const float az, const flo
  */
 const char *sac_scnl_print( struct SAChead *sh )
 {
-	static char result[SAC_MAX_SCNL_LENGTH] = { 0 };
+	static _Thread_local char result[SAC_MAX_SCNL_LENGTH] = { 0 };
 
 	char sta[K_LEN + 1]  = { 0 };
 	char chan[K_LEN + 1] = { 0 };
@@ -223,9 +262,7 @@ double sac_reftime_fetch( struct SAChead *sh )
  */
 static int read_sac_header( FILE *fp, struct SAChead *psh )
 {
-	int filesize;
-	int result = 0;
-	struct SAChead2 *psh2;
+	long filesize;
 
 /* Obtain file size */
 	fseek(fp, 0, SEEK_END);
@@ -233,21 +270,39 @@ static int read_sac_header( FILE *fp, struct SAChead *psh )
 	rewind(fp);
 
 /* */
-	psh2 = (struct SAChead2 *)psh;
 	if ( fread(psh, sizeof(struct SAChead2), 1, fp) != 1 ) {
 		fprintf(stderr, "Error reading SAC file: %s!\n", strerror(errno));
 		return -1;
 	}
+
+	return check_sac_byteorder( psh, filesize );
+}
+
+/**
+ * @brief Check the byte order of SAC header by the total size, and swap it when needed.
+ *
+ * @param psh Header pointer of the read-in buffer
+ * @param filesize Total size of the SAC file
+ * @return int
+ * @returns: 0 on success
+ *          1 on success and if byte swapping is needed
+ *         -1 on error
+ */
+static int check_sac_byteorder( struct SAChead *psh, const long filesize )
+{
+	int result = 0;
+	struct SAChead2 *psh2 = (struct SAChead2 *)psh;
+
 /* */
 	if ( filesize != (sizeof(struct SAChead) + (psh->npts * sizeof(float))) ) {
 		result = 1;
-		fprintf(stderr, "WARNING: Swapping is needed! (filesize %d, psh.npts %d)\n", filesize, psh->npts);
+		fprintf(stderr, "WARNING: Swapping is needed! (filesize %ld, psh.npts %d)\n", filesize, psh->npts);
 		for ( int i = 0; i < NUM_FLOAT; i++ )
 			swap_order_4byte( psh2->SACfloat + i );
 		for ( int i = 0; i < MAXINT; i++ )
 			swap_order_4byte( psh2->SACint + i );
 		if ( filesize != (sizeof(struct SAChead) + (psh->npts * sizeof(float))) ) {
-			fprintf(stderr, "ERROR: Swapping is needed again! (filesize %d, psh.npts %d)\n", filesize, psh->npts);
+			fprintf(stderr, "ERROR: Swapping is needed again! (filesize %ld, psh.npts %d)\n", filesize, psh->npts);
 			result = -1;
 		}
 	}
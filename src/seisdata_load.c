@@ -12,9 +12,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <float.h>
 #include <math.h>
 #include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
 /* */
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -22,95 +26,293 @@
 #include <postmajor.h>
 #include <sac.h>
 #include <libmseed.h>
+#include <msindex.h>
+#include <tank.h>
+#include <tararchive.h>
+#include <pmevent.h>
+#include <seisdata_load.h>
 
 /* */
 #define MAX_FILE_NAME          512
 #define SAC_FILE_NAME_FORMAT  "%s/%s.%s.%s.%s"
+#define SAC_MEMBER_NAME_FORMAT "%s.%s.%s.%s"
+#define SDS_FILE_NAME_FORMAT  "%s/%d/%s/%s/%s.D/%s.%s.%s.%s.D.%d.%03d"
+#define SDS_DAY_NSTIME         (86400 * (nstime_t)NSTMODULUS)
+#define SDS_DAY_MARGIN         300
+#define SDS_MAX_DAY_FILES      8
+#define MS_STREAM_BLOCK_SIZE  (4 * 1024 * 1024)
+
+/*----------------------------------------------------------------------*
+ * Definition of the block of miniSEED stream, the records in the trace *
+ * list refer to it directly, so it should be kept until the release    *
+ *----------------------------------------------------------------------*/
+typedef struct ms_stream_block {
+	struct ms_stream_block *next;
+	size_t                  size;
+	char                    data[];
+} MS_STREAM_BLOCK;
+
+/*----------------------------------------------------------------------*
+ * Definition of the reader for one channel within the SDS archive     *
+ *----------------------------------------------------------------------*/
+typedef struct {
+	pthread_t     tid;
+	_Bool         joinable;
+	int           result;
+	int           nfiles;
+	char          sid[LM_SIDLEN];
+	char          files[SDS_MAX_DAY_FILES][MAX_FILE_NAME];
+	nstime_t      starttime;
+	nstime_t      endtime;
+	MS3TraceList *mstl;
+} SDS_CHANNEL_READER;
+
 /* */
 static float *subs_gap2nan( float [], const int, const float );
 static float *apply_gain2data( float [], const int, const float );
 static float *dmean_data( float [], const int, const double, int * );
+static MSINDEX *open_ms_index( const char * );
+static void     release_ms_segment( MS3TraceSeg *, const _Bool );
+static int      assemble_ms_traces( SNL_INFO *, MS3TraceID *[NUM_CHANNEL_SNL], const _Bool );
+static void    *read_sds_channel( void * );
+static int      read_ms_stream( SEISDATA_CONTEXT *, MS3TraceList *, const int );
+static int      list_sds_day_files( const SEISDATA_CONTEXT *, const SNL_INFO *, const char *, const int, char [][MAX_FILE_NAME] );
+static int      append_file_identity( char *, const size_t, const char * );
+
+/**
+ * @brief Initialize the loading context, nothing is opened & the event window is unlimited.
+ *
+ * @param ctx
+ */
+void seisdata_context_init( SEISDATA_CONTEXT *ctx )
+{
+	memset(ctx, 0, sizeof(SEISDATA_CONTEXT));
+	ctx->window_start = INT64_MIN;
+	ctx->window_end   = INT64_MAX;
+
+	return;
+}
+
+/**
+ * @brief Set the time window of the event, the loaders can skip the data outside of it.
+ *
+ * @param ctx
+ * @param starttime
+ * @param endtime
+ */
+void seisdata_window_set( SEISDATA_CONTEXT *ctx, const double starttime, const double endtime )
+{
+	ctx->window_start = (nstime_t)(starttime * NSTMODULUS);
+	ctx->window_end   = (nstime_t)(endtime * NSTMODULUS);
+
+	return;
+}
+
+/**
+ * @brief Turn on the loading of miniSEED thru the record index sidecar.
+ *
+ * @param ctx
+ */
+void seisdata_ms_index_enable( SEISDATA_CONTEXT *ctx )
+{
+	ctx->ms_index_switch = true;
+
+	return;
+}
+
+/**
+ * @brief Keep the loaded records of miniSEED & members of archive, so the same input can be loaded by
+ *        several events.
+ *
+ * @param ctx
+ */
+void seisdata_keep_input_enable( SEISDATA_CONTEXT *ctx )
+{
+	ctx->keep_input = true;
+
+	return;
+}
+
+/**
+ * @brief Identify the input SAC files of the station by their sizes & modification times, or the whole
+ *        archive when the path is a regular file.
+ *
+ * @param ctx
+ * @param snl_info
+ * @param path
+ * @param identity
+ * @param size
+ * @return int
+ */
+int seisdata_identify_sac( const SEISDATA_CONTEXT *ctx, const SNL_INFO *snl_info, const char *path, char *identity, const size_t size )
+{
+	char        filename[MAX_FILE_NAME] = { 0 };
+	struct stat st;
+
+/* */
+	identity[0] = '\0';
+	if ( !stat(path, &st) && S_ISREG(st.st_mode) )
+		return append_file_identity( identity, size, path );
+/* */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		snprintf(filename, sizeof(filename), SAC_FILE_NAME_FORMAT, path, snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc);
+		if ( append_file_identity( identity, size, filename ) < 0 )
+			return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Identify the day files of the station within the SDS archive.
+ *
+ * @param ctx
+ * @param snl_info
+ * @param path
+ * @param identity
+ * @param size
+ * @return int
+ */
+int seisdata_identify_sds( const SEISDATA_CONTEXT *ctx, const SNL_INFO *snl_info, const char *path, char *identity, const size_t size )
+{
+	char files[SDS_MAX_DAY_FILES][MAX_FILE_NAME];
+	int  nfiles;
+
+/* */
+	identity[0] = '\0';
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		nfiles = list_sds_day_files( ctx, snl_info, path, i, files );
+		for ( register int j = 0; j < nfiles; j++ )
+			if ( append_file_identity( identity, size, files[j] ) < 0 )
+				return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Identify the single input file shared by all the stations, e.g. miniSEED, tank or container.
+ *
+ * @param ctx
+ * @param snl_info
+ * @param path
+ * @param identity
+ * @param size
+ * @return int
+ */
+int seisdata_identify_file( const SEISDATA_CONTEXT *ctx, const SNL_INFO *snl_info, const char *path, char *identity, const size_t size )
+{
+/* The stream can't be identified */
+	if ( !strcmp(path, "-") )
+		return -1;
 /* */
-static void *LoadContextSAC  = NULL;
-static void *LoadContextMS   = NULL;
-static void *LoadContextTANK = NULL;
+	identity[0] = '\0';
+
+	return append_file_identity( identity, size, path );
+}
 
 /**
  * @brief
  *
+ * @param ctx
  * @param snl_info
  * @param path
  * @return int
  */
-int seisdata_load_sac( SNL_INFO *snl_info, const char *path )
+int seisdata_load_sac( SEISDATA_CONTEXT *ctx, SNL_INFO *snl_info, const char *path )
 {
 	char   filename[MAX_FILE_NAME] = { 0 };
 	struct SAChead sh;
+	struct stat    st;
+	TAR_MEMBER    *member = NULL;
 	float *_seis = NULL;
 	int    gap   = 0;
 
+/* The path of a regular file should be the (compressed) tar archive of SAC files, read it all at the first time */
+	if ( !ctx->sac && !stat(path, &st) && S_ISREG(st.st_mode) ) {
+		fprintf(stderr, "Reading the SAC files from the archive %s...\n", path);
+		if ( !(ctx->sac = tar_archive_open( path )) ) {
+			fprintf(stderr, "ERROR! Cannot read the archive: %s\n", path);
+			return -2;
+		}
+	}
+
 /* Just a initialization */
-	snl_info->npts      = -1;
-	snl_info->delta     = -1.0;
-	snl_info->starttime = -1.0;
+	snl_info->state->npts      = -1;
+	snl_info->state->delta     = -1.0;
+	snl_info->state->starttime = -1.0;
 	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ )
-		snl_info->seis[i] = NULL;
+		snl_info->state->seis[i] = NULL;
 
 /* Open all the three channels' SAC files */
 	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
-	/* Opening the SAC files */
-		sprintf(filename, SAC_FILE_NAME_FORMAT, path, snl_info->sta, snl_info->chan[i], snl_info->net, snl_info->loc);
-		if ( sac_file_load( filename, &sh, &_seis ) < 0 )
-			return -1;
+	/* Loading the SAC files from the archive members or opening them */
+		if ( ctx->sac ) {
+			sprintf(filename, SAC_MEMBER_NAME_FORMAT, snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc);
+			if ( !(member = tar_member_find( (TAR_ARCHIVE *)ctx->sac, filename )) || !member->data ) {
+				fprintf(stderr, "Error finding %s in the archive %s\n", filename, path);
+				return -1;
+			}
+			gap = sac_buffer_load( member->data, member->size, &sh, &_seis );
+			if ( !ctx->keep_input )
+				tar_member_release( member );
+			if ( gap < 0 )
+				return -1;
+		}
+		else {
+			sprintf(filename, SAC_FILE_NAME_FORMAT, path, snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc);
+			if ( sac_file_load( filename, &sh, &_seis ) < 0 )
+				return -1;
+		}
 
 	/* Check the consistency of npts */
-		if ( snl_info->npts < 0 ) {
-			snl_info->npts = (int)sh.npts;
+		if ( snl_info->state->npts < 0 ) {
+			snl_info->state->npts = (int)sh.npts;
 		}
-		else if ( snl_info->npts != (int)sh.npts ) {
+		else if ( snl_info->state->npts != (int)sh.npts ) {
 			fprintf(
 				stderr, "WARNING! There is a different npts within the SAC files of %s.%s.%s.%s.\n",
-				snl_info->sta, snl_info->chan[i], snl_info->net, snl_info->loc
+				snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc
 			);
-			if ( (int)sh.npts < snl_info->npts )
-				snl_info->npts = (int)sh.npts;
+			if ( (int)sh.npts < snl_info->state->npts )
+				snl_info->state->npts = (int)sh.npts;
 		}
 	/* Check the consistency of delta */
-		if ( snl_info->delta < 0.0 ) {
-			snl_info->delta = sh.delta;
+		if ( snl_info->state->delta < 0.0 ) {
+			snl_info->state->delta = sh.delta;
 		}
-		else if ( fabs(snl_info->delta - sh.delta) > FLT_EPSILON ) {
+		else if ( fabs(snl_info->state->delta - sh.delta) > FLT_EPSILON ) {
 			fprintf(
 				stderr, "ERROR! There is a different delta within the SAC files of %s.%s.%s.%s.\n",
-				snl_info->sta, snl_info->chan[i], snl_info->net, snl_info->loc
+				snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc
 			);
 			free(_seis);
 			return -2;
 		}
 	/* Check the consistency of start time of waveform */
-		if ( snl_info->starttime < 0.0 ) {
-			snl_info->starttime = sac_reftime_fetch( &sh );
+		if ( snl_info->state->starttime < 0.0 ) {
+			snl_info->state->starttime = sac_reftime_fetch( &sh );
 		}
-		else if ( fabs(snl_info->starttime - sac_reftime_fetch( &sh )) > FLT_EPSILON ) {
+		else if ( fabs(snl_info->state->starttime - sac_reftime_fetch( &sh )) > FLT_EPSILON ) {
 			fprintf(
 				stderr, "ERROR! There is a different start time within the SAC files of %s.%s.%s.%s.\n",
-				snl_info->sta, snl_info->chan[i], snl_info->net, snl_info->loc
+				snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc
 			);
 			free(_seis);
 			return -2;
 		}
 	/* */
-		subs_gap2nan( _seis, snl_info->npts, SACUNDEF );
-		apply_gain2data( _seis, snl_info->npts, snl_info->gain[i] );
-		dmean_data( _seis, snl_info->npts, 1.0 / snl_info->delta, &gap );
+		subs_gap2nan( _seis, snl_info->state->npts, SACUNDEF );
+		apply_gain2data( _seis, snl_info->state->npts, snl_info->meta->gain[i] );
+		dmean_data( _seis, snl_info->state->npts, 1.0 / snl_info->state->delta, &gap );
 		if ( gap ) {
 			fprintf(
 				stderr, "Found %d gaps within total %d samples in %s, filled with mean value!\n",
-				gap, snl_info->npts, sac_scnl_print( &sh )
+				gap, snl_info->state->npts, sac_scnl_print( &sh )
 			);
 		}
 	/* */
-		snl_info->seis[i] = _seis;
+		snl_info->state->seis[i] = _seis;
 	}
 
 	return 0;
@@ -119,35 +321,212 @@ int seisdata_load_sac( SNL_INFO *snl_info, const char *path )
 /**
  * @brief
  *
+ * @param ctx
  * @param snl_info
  * @param path
  * @return int
  */
-int seisdata_load_ms( SNL_INFO *snl_info, const char *path )
+int seisdata_load_ms( SEISDATA_CONTEXT *ctx, SNL_INFO *snl_info, const char *path )
 {
 	MS3TraceID *tid[NUM_CHANNEL_SNL] = { NULL };
-	int         offset   = 0;
-	int         npts     = 0;
-	int         seis_idx = 0;
-	float      *_seis    = NULL;
-	nstime_t    earliest = 0;
-	nstime_t    latest   = 0;
-	nstime_t    lastend  = 0;
-	double      samprate = -1.0;
-	uint8_t     samplesize;
-	char        sampletype;
 	char        sid[LM_SIDLEN] = { 0 };
 
 /* Only mapping the trace list at the first time */
-	if ( !LoadContextMS ) {
-	/* */
-		LoadContextMS = mstl3_init(NULL);
+	if ( !ctx->ms ) {
+		ctx->ms = mstl3_init(NULL);
+	/* Streaming from the standard input, the records will be parsed as they arrive */
+		if ( !strcmp(path, "-") ) {
+			fprintf(stderr, "Reading the miniSEED stream from the standard input...\n");
+			if ( read_ms_stream( ctx, (MS3TraceList *)ctx->ms, STDIN_FILENO ) < 0 ) {
+				fprintf(stderr, "ERROR! Cannot read miniSEED from the standard input!\n");
+				return -2;
+			}
+		}
+	/* With the index, the records will be added into the trace list station by station, only for one event */
+		else if ( ctx->ms_index_switch && !ctx->keep_input && (ctx->ms_index = open_ms_index( path )) ) {
+			fprintf(stderr, "Using the record index of the miniSEED file %s...\n", path);
+		}
 	/* Read all miniSEED from the path, accumulate in MS3TraceList */
-		fprintf(stderr, "Mapping the miniSEED file %s into memory...\n", path);
-		if ( ms3_readtracelist((MS3TraceList **)&LoadContextMS, path, NULL, 0, MSF_VALIDATECRC | MSF_RECORDLIST, 0) != MS_NOERROR ) {
+		else {
+			fprintf(stderr, "Mapping the miniSEED file %s into memory...\n", path);
+			if ( ms3_readtracelist((MS3TraceList **)&ctx->ms, path, NULL, 0, MSF_VALIDATECRC | MSF_RECORDLIST | MSF_MMAPFILE | MSF_FIXEDRECLEN, 0) != MS_NOERROR ) {
+				fprintf(
+					stderr, "ERROR! Cannot read miniSEED from file: %s\n", path
+				);
+				return -2;
+			}
+		}
+	}
+
+/* */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+	/* */
+		snl_info->state->seis[i] = NULL;
+	/* */
+		ms_nslc2sid(sid, LM_SIDLEN, 0, snl_info->meta->net, snl_info->meta->sta, strcmp("--", snl_info->meta->loc) ? snl_info->meta->loc : NULL, snl_info->meta->chan[i]);
+	/* Only fetch the records overlapping the event window from the index */
+		if (
+			ctx->ms_index && !mstl3_findID((MS3TraceList *)ctx->ms, sid, 0, NULL) &&
+			msindex_fetch( (MSINDEX *)ctx->ms_index, sid, ctx->window_start, ctx->window_end, (MS3TraceList *)ctx->ms ) < 0
+		) {
+			return -2;
+		}
+	/* */
+		if ( !(tid[i] = mstl3_findID((MS3TraceList *)ctx->ms, sid, 0, NULL)) ) {
+			fprintf(stderr, "ERROR! Cannot find the SID: %s in the miniSEED file: %s\n", sid, path);
+			return -1;
+		}
+	}
+
+	return assemble_ms_traces( snl_info, tid, ctx->keep_input );
+}
+
+/**
+ * @brief Load the event window from the SeisComP Data Structure (SDS) archive at the path, the day files
+ *        of three channels are read in parallel & only the records overlapping the window are kept.
+ *
+ * @param ctx
+ * @param snl_info
+ * @param path
+ * @return int
+ */
+int seisdata_load_sds( SEISDATA_CONTEXT *ctx, SNL_INFO *snl_info, const char *path )
+{
+	SDS_CHANNEL_READER readers[NUM_CHANNEL_SNL];
+	MS3TraceID        *tid[NUM_CHANNEL_SNL] = { NULL };
+	const char        *loc    = strcmp("--", snl_info->meta->loc) ? snl_info->meta->loc : NULL;
+	int                result = 0;
+
+/* */
+	if ( ctx->window_start == INT64_MIN || ctx->window_end == INT64_MAX ) {
+		fprintf(stderr, "ERROR! The event window is needed for reading the SDS archive!\n");
+		return -2;
+	}
+
+/* Derive the day files covering the window, a little margin for the record across midnight */
+	memset(readers, 0, sizeof(readers));
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		snl_info->state->seis[i] = NULL;
+		ms_nslc2sid(readers[i].sid, LM_SIDLEN, 0, snl_info->meta->net, snl_info->meta->sta, loc, snl_info->meta->chan[i]);
+		readers[i].nfiles    = list_sds_day_files( ctx, snl_info, path, i, readers[i].files );
+		readers[i].starttime = ctx->window_start;
+		readers[i].endtime   = ctx->window_end;
+	}
+/* Read the channels in parallel, each has its own trace list */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		if ( pthread_create(&readers[i].tid, NULL, read_sds_channel, &readers[i]) ) {
+		/* Just read it in this thread */
+			read_sds_channel( &readers[i] );
+		}
+		else {
+			readers[i].joinable = true;
+		}
+	}
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		if ( readers[i].joinable )
+			pthread_join(readers[i].tid, NULL);
+		if ( readers[i].result < 0 && result >= 0 )
+			result = readers[i].result;
+		else if ( readers[i].mstl && !(tid[i] = mstl3_findID(readers[i].mstl, readers[i].sid, 0, NULL)) && result >= 0 )
+			result = -1;
+	}
+/* */
+	if ( result < 0 )
+		fprintf(stderr, "ERROR! Cannot find the data of %s.%s.%s in the SDS archive: %s\n", snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, path);
+	else
+		result = assemble_ms_traces( snl_info, tid, false );
+/* */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ )
+		if ( readers[i].mstl )
+			mstl3_free(&readers[i].mstl, 0);
+
+	return result;
+}
+
+/**
+ * @brief Load the station from the native event container, the samples are copied from the mapped file
+ *        directly, only rescaled when the gain in station list is different from the stored one.
+ *
+ * @param ctx
+ * @param snl_info
+ * @param path
+ * @return int
+ */
+int seisdata_load_pme( SEISDATA_CONTEXT *ctx, SNL_INFO *snl_info, const char *path )
+{
+	const PMEVENT_STATION *station = NULL;
+	const float           *data    = NULL;
+	float                 *_seis   = NULL;
+
+/* Only mapping the container at the first time */
+	if ( !ctx->pme ) {
+		fprintf(stderr, "Mapping the event container %s into memory...\n", path);
+		if ( !(ctx->pme = pmevent_open( path )) )
+			return -2;
+	}
+/* */
+	if ( !(station = pmevent_station_find( (PMEVENT *)ctx->pme, snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc )) ) {
+		fprintf(stderr, "ERROR! Cannot find the station %s.%s.%s in the container: %s\n", snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, path);
+		return -1;
+	}
+/* */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		snl_info->state->seis[i] = NULL;
+		if ( strncmp(snl_info->meta->chan[i], station->chan[i], PMEVENT_CODE_LEN) ) {
 			fprintf(
-				stderr, "ERROR! Cannot read miniSEED from file: %s\n", path
+				stderr, "ERROR! The channel %s of %s.%s.%s is not in the container: %s\n",
+				snl_info->meta->chan[i], snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, path
 			);
+			return -1;
+		}
+	}
+/* */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+		if ( !(data = pmevent_channel_data( (PMEVENT *)ctx->pme, station, i )) ) {
+			fprintf(stderr, "ERROR! The samples of %s.%s.%s are out of the container: %s\n", snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, path);
+			return -2;
+		}
+		if ( !(_seis = (float *)malloc(station->npts * sizeof(float))) ) {
+			fprintf(stderr, "ERROR! Out of memory for %d float samples\n", station->npts);
+			return -2;
+		}
+		memcpy(_seis, data, station->npts * sizeof(float));
+		if ( fabs(snl_info->meta->gain[i] - station->gain[i]) > FLT_EPSILON )
+			apply_gain2data( _seis, station->npts, snl_info->meta->gain[i] / station->gain[i] );
+	/* Keep the buffer pointer */
+		snl_info->state->seis[i] = _seis;
+	}
+/* */
+	snl_info->state->npts      = station->npts;
+	snl_info->state->delta     = station->delta;
+	snl_info->state->starttime = station->starttime;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param ctx
+ * @param snl_info
+ * @param path
+ * @return int
+ */
+int seisdata_load_tank( SEISDATA_CONTEXT *ctx, SNL_INFO *snl_info, const char *path )
+{
+	const TANK_SCNL *scnl[NUM_CHANNEL_SNL] = { NULL };
+	float           *_seis    = NULL;
+	int              npts     = 0;
+	int              gap      = 0;
+	double           earliest = -1.0;
+	double           latest   = -1.0;
+	double           samprate = -1.0;
+
+/* Only mapping & indexing the tank at the first time */
+	if ( !ctx->tank ) {
+		fprintf(stderr, "Mapping & indexing the tank file %s...\n", path);
+		if ( !(ctx->tank = tank_open( path )) ) {
+			fprintf(stderr, "ERROR! Cannot read TRACEBUF2 from file: %s\n", path);
 			return -2;
 		}
 	}
@@ -155,19 +534,185 @@ int seisdata_load_ms( SNL_INFO *snl_info, const char *path )
 /* */
 	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
 	/* */
-		snl_info->seis[i] = NULL;
-	/* */
-		ms_nslc2sid(sid, LM_SIDLEN, 0, snl_info->net, snl_info->sta, strcmp("--", snl_info->loc) ? snl_info->loc : NULL, snl_info->chan[i]);
-		if ( !(tid[i] = mstl3_findID((MS3TraceList *)LoadContextMS, sid, 0, NULL)) ) {
-			fprintf(stderr, "ERROR! Cannot find the SID: %s in the miniSEED file: %s\n", sid, path);
+		snl_info->state->seis[i] = NULL;
+		if ( !(scnl[i] = tank_scnl_find( (TANK *)ctx->tank, snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc )) ) {
+			fprintf(
+				stderr, "ERROR! Cannot find the SCNL: %s.%s.%s.%s in the tank file: %s\n",
+				snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc, path
+			);
 			return -1;
 		}
+	/* */
+		if ( (earliest > 0.0 && scnl[i]->latest < earliest) || (latest > 0.0 && scnl[i]->earliest > latest) ) {
+			fprintf(
+				stderr, "ERROR! There is an out of time range trace within the tank file of SCNL: %s.%s.%s.%s\n",
+				snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc
+			);
+			return -2;
+		}
+		if ( earliest < 0.0 || earliest > scnl[i]->earliest )
+			earliest = scnl[i]->earliest;
+		if ( latest < 0.0 || latest < scnl[i]->latest )
+			latest = scnl[i]->latest;
+	/* Check the consistency of delta */
+		if ( samprate < 0.0 ) {
+			samprate = scnl[i]->samprate;
+		}
+		else if ( fabs(samprate - scnl[i]->samprate) > FLT_EPSILON ) {
+			fprintf(
+				stderr, "ERROR! There is a different sampleing rate within the tank file of SCNL: %s.%s.%s.%s\n",
+				snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc
+			);
+			return -2;
+		}
+	}
+/* Just derive the maximum number of samples we need here */
+	npts = (int)((latest - earliest) * samprate + 0.5) + 1;
+/* Again, go thru all the traces */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
+	/* Create the buffer space for storaging the seismic data, and then fill with the gap value, NAN */
+		if ( !(_seis = (float *)calloc(npts, sizeof(float))) ) {
+			fprintf(stderr, "ERROR! Out of memory for %d float samples\n", npts);
+			return -2;
+		}
+		for ( register int j = 0; j < npts; j++ )
+			_seis[j] = NAN;
+	/* The samples of packets are converted into the buffer directly */
+		tank_scnl_fill( (TANK *)ctx->tank, scnl[i], earliest, _seis, npts, &gap );
+		if ( gap ) {
+			fprintf(
+				stderr, "Found %d gaps between the packets of SCNL: %s.%s.%s.%s\n",
+				gap, snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc
+			);
+		}
+	/* Preprocess the seismic data */
+		apply_gain2data( _seis, npts, snl_info->meta->gain[i] );
+		dmean_data( _seis, npts, samprate, &gap );
+		if ( gap ) {
+			fprintf(
+				stderr, "Found %d gaps within total %d samples in SCNL: %s.%s.%s.%s, filled with mean value!\n",
+				gap, npts, snl_info->meta->sta, snl_info->meta->chan[i], snl_info->meta->net, snl_info->meta->loc
+			);
+		}
+	/* Keep the buffer pointer */
+		snl_info->state->seis[i] = _seis;
+	}
+/* */
+	snl_info->state->npts      = npts;
+	snl_info->state->delta     = 1.0 / samprate;
+	snl_info->state->starttime = earliest;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param ctx
+ */
+void seisdata_release_sac( SEISDATA_CONTEXT *ctx )
+{
+	if ( ctx->sac ) {
+		tar_archive_close( (TAR_ARCHIVE *)ctx->sac );
+		ctx->sac = NULL;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param ctx
+ */
+void seisdata_release_ms( SEISDATA_CONTEXT *ctx )
+{
+	if ( ctx->ms )
+		mstl3_free((MS3TraceList **)&ctx->ms, 0);
+	for ( MS_STREAM_BLOCK *block = (MS_STREAM_BLOCK *)ctx->ms_stream, *next; block; block = next ) {
+		next = block->next;
+		free(block);
+	}
+	ctx->ms_stream = NULL;
+	if ( ctx->ms_index ) {
+		msindex_close( (MSINDEX *)ctx->ms_index );
+		ctx->ms_index = NULL;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param ctx
+ */
+void seisdata_release_tank( SEISDATA_CONTEXT *ctx )
+{
+	if ( ctx->tank ) {
+		tank_close( (TANK *)ctx->tank );
+		ctx->tank = NULL;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param ctx
+ */
+void seisdata_release_pme( SEISDATA_CONTEXT *ctx )
+{
+	if ( ctx->pme ) {
+		pmevent_close( (PMEVENT *)ctx->pme );
+		ctx->pme = NULL;
+	}
+
+	return;
+}
+
+/**
+ * @brief Nothing to release, the day files of SDS archive are read & released station by station.
+ *
+ * @param ctx
+ */
+void seisdata_release_sds( SEISDATA_CONTEXT *ctx )
+{
+	return;
+}
+
+/**
+ * @brief Assemble the trace segments of three channels into the float buffers of station, the decoded
+ *        samples & records of each segment will be released after copying, only the samples when the
+ *        records should be kept.
+ *
+ * @param snl_info
+ * @param tid
+ * @param keep_records
+ * @return int
+ */
+static int assemble_ms_traces( SNL_INFO *snl_info, MS3TraceID *tid[NUM_CHANNEL_SNL], const _Bool keep_records )
+{
+	int         offset   = 0;
+	int         npts     = 0;
+	int         seis_idx = 0;
+	float      *_seis    = NULL;
+	nstime_t    earliest = 0;
+	nstime_t    latest   = 0;
+	nstime_t    lastend  = 0;
+	double      samprate = -1.0;
+	uint8_t     samplesize;
+	char        sampletype;
+
+/* */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL; i++ ) {
 	/* */
 		if (
 			(earliest && tid[i]->latest < earliest) ||
 			(latest && tid[i]->earliest > latest)
 		) {
-			fprintf(stderr, "ERROR! There is an out of time range trace within the miniSEED files of SID: %s\n", sid);
+			fprintf(stderr, "ERROR! There is an out of time range trace within the miniSEED files of SID: %s\n", tid[i]->sid);
 			return -2;
 		}
 	/* */
@@ -181,7 +726,7 @@ int seisdata_load_ms( SNL_INFO *snl_info, const char *path )
 			samprate = tid[i]->first->samprate;
 		}
 		else if ( fabs(samprate - tid[i]->first->samprate) > FLT_EPSILON ) {
-			fprintf(stderr, "ERROR! There is a different sampleing rate within the miniSEED files of SID: %s\n", sid);
+			fprintf(stderr, "ERROR! There is a different sampleing rate within the miniSEED files of SID: %s\n", tid[i]->sid);
 			return -2;
 		}
 	}
@@ -200,6 +745,12 @@ int seisdata_load_ms( SNL_INFO *snl_info, const char *path )
 		lastend = earliest;
 		seis_idx = 0;
 		for ( MS3TraceSeg *seg = tid[i]->first; seg; seg = seg->next ) {
+		/* The records of this segment had been released by the previous loading */
+			if ( !seg->recordlist ) {
+				fprintf(stderr, "ERROR! The records of SID: %s had already been loaded & released!\n", tid[i]->sid);
+				free(_seis);
+				return -2;
+			}
 		/* Check the data sample size & type and then unpack it */
 			ms_encoding_sizetype(seg->recordlist->first->msr->encoding, &samplesize, &sampletype);
 			mstl3_unpack_recordlist(tid[i], seg, NULL, 0, 0);
@@ -233,9 +784,11 @@ int seisdata_load_ms( SNL_INFO *snl_info, const char *path )
 			}
 		/* Save the last end time for next loop usage */
 			lastend = seg->endtime;
+		/* The data had been copied into our own buffer, release the decoded samples & records */
+			release_ms_segment( seg, keep_records );
 		}
 	/* Preprocess the seismic data */
-		apply_gain2data( _seis, npts, snl_info->gain[i] );
+		apply_gain2data( _seis, npts, snl_info->meta->gain[i] );
 		dmean_data( _seis, npts, samprate, &seis_idx );
 		if ( seis_idx ) {
 			fprintf(
@@ -244,60 +797,257 @@ int seisdata_load_ms( SNL_INFO *snl_info, const char *path )
 			);
 		}
 	/* Keep the buffer pointer */
-		snl_info->seis[i] = _seis;
+		snl_info->state->seis[i] = _seis;
 	}
 /* */
-	snl_info->npts      = npts;
-	snl_info->delta     = 1.0 / samprate;
-	snl_info->starttime = earliest * 1.0e-9;
+	snl_info->state->npts      = npts;
+	snl_info->state->delta     = 1.0 / samprate;
+	snl_info->state->starttime = earliest * 1.0e-9;
 
 	return 0;
 }
 
+
 /**
- * @brief
+ * @brief Thread of reading the day files of one channel within the SDS archive, only the records of
+ *        the channel overlapping the event window will be kept.
  *
+ * @param arg
+ * @return void*
+ */
+static void *read_sds_channel( void *arg )
+{
+	SDS_CHANNEL_READER *reader = (SDS_CHANNEL_READER *)arg;
+	MS3Selections       selection;
+	MS3SelectTime       selecttime;
+	struct stat         fs;
+
+/* */
+	if ( !(reader->mstl = mstl3_init(NULL)) ) {
+		reader->result = -2;
+		return NULL;
+	}
+/* */
+	memset(&selection, 0, sizeof(selection));
+	memset(&selecttime, 0, sizeof(selecttime));
+	strncpy(selection.sidpattern, reader->sid, sizeof(selection.sidpattern) - 1);
+	selecttime.starttime = reader->starttime;
+	selecttime.endtime   = reader->endtime;
+	selection.timewindows = &selecttime;
+/* The day file might be absent, e.g. the station was not recording at that day */
+	for ( register int i = 0; i < reader->nfiles; i++ ) {
+		if ( stat(reader->files[i], &fs) || !S_ISREG(fs.st_mode) )
+			continue;
+		if (
+			ms3_readtracelist_selection(
+				&reader->mstl, reader->files[i], NULL, &selection, 0,
+				MSF_VALIDATECRC | MSF_RECORDLIST | MSF_MMAPFILE | MSF_FIXEDRECLEN, 0
+			) != MS_NOERROR
+		) {
+			fprintf(stderr, "ERROR! Cannot read miniSEED from file: %s\n", reader->files[i]);
+			reader->result = -2;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Read the miniSEED stream from the file descriptor (e.g. a pipe), the complete records are parsed
+ *        into the trace list as soon as they arrive & the incomplete tail is carried to the next block.
+ *
+ * @param ctx
+ * @param mstl
+ * @param fd
+ * @return int
+ */
+static int read_ms_stream( SEISDATA_CONTEXT *ctx, MS3TraceList *mstl, const int fd )
+{
+	MS_STREAM_BLOCK *block  = NULL;
+	size_t           parsed = 0;
+	size_t           fill   = 0;
+	ssize_t          nread  = 1;
+	int64_t          reclen;
+	uint8_t          version;
+
+/* */
+	while ( nread > 0 || parsed < fill ) {
+	/* Start a new block when the current one is full, the unparsed tail will be moved into it */
+		if ( !block || (fill == block->size && nread > 0) ) {
+			MS_STREAM_BLOCK *_block = NULL;
+			size_t           _size  = MS_STREAM_BLOCK_SIZE;
+
+			if ( (fill - parsed) * 2 > _size )
+				_size = (fill - parsed) * 2;
+			if ( !(_block = (MS_STREAM_BLOCK *)malloc(sizeof(MS_STREAM_BLOCK) + _size)) ) {
+				fprintf(stderr, "ERROR! Out of memory for the miniSEED stream!\n");
+				return -2;
+			}
+			_block->next = (MS_STREAM_BLOCK *)ctx->ms_stream;
+			_block->size = _size;
+			if ( block )
+				memcpy(_block->data, block->data + parsed, fill - parsed);
+			ctx->ms_stream = _block;
+			block  = _block;
+			fill  -= parsed;
+			parsed = 0;
+		}
+	/* */
+		if ( nread > 0 ) {
+			if ( (nread = read(fd, block->data + fill, block->size - fill)) < 0 ) {
+				fprintf(stderr, "ERROR! Cannot read the miniSEED stream!\n");
+				return -2;
+			}
+			fill += nread;
+		}
+	/* Only pass the complete records to the parser */
+		size_t end = parsed;
+		while ( (fill - end) >= MINRECLEN ) {
+			reclen = ms3_detect(block->data + end, fill - end, &version);
+		/* The length is unknown until the next header or the end of stream */
+			if ( reclen == 0 && nread == 0 )
+				reclen = fill - end;
+			if ( reclen < 0 ) {
+				fprintf(stderr, "ERROR! There is a non-miniSEED data within the stream!\n");
+				return -2;
+			}
+			if ( !reclen || (size_t)reclen > (fill - end) )
+				break;
+			end += reclen;
+		}
+	/* */
+		if ( end > parsed ) {
+			if ( mstl3_readbuffer(&mstl, block->data + parsed, end - parsed, 0, MSF_VALIDATECRC | MSF_RECORDLIST, NULL, 0) < 0 )
+				return -2;
+			parsed = end;
+		}
+	/* The trailing bytes at the end of stream can't form a record */
+		if ( nread == 0 && parsed < fill && (end == parsed) ) {
+			fprintf(stderr, "WARNING! Discarded %ld trailing bytes of the miniSEED stream!\n", (long)(fill - parsed));
+			break;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * @brief List the day files of the channel within the SDS archive covering the event window, a little
+ *        margin for the record across midnight.
+ *
+ * @param ctx
  * @param snl_info
  * @param path
+ * @param channel
+ * @param files
  * @return int
  */
-int seisdata_load_tank( SNL_INFO *snl_info, const char *path )
+static int list_sds_day_files( const SEISDATA_CONTEXT *ctx, const SNL_INFO *snl_info, const char *path, const int channel, char files[][MAX_FILE_NAME] )
 {
-	return -1;
+	const char *loc    = strcmp("--", snl_info->meta->loc) ? snl_info->meta->loc : "";
+	int         result = 0;
+	uint16_t    year;
+	uint16_t    yday;
+
+/* */
+	for (
+		int64_t day = (ctx->window_start - SDS_DAY_MARGIN * (nstime_t)NSTMODULUS) / SDS_DAY_NSTIME;
+		day <= ctx->window_end / SDS_DAY_NSTIME && result < SDS_MAX_DAY_FILES;
+		day++
+	) {
+		ms_nstime2time(day * SDS_DAY_NSTIME, &year, &yday, NULL, NULL, NULL, NULL);
+		snprintf(
+			files[result++], MAX_FILE_NAME, SDS_FILE_NAME_FORMAT,
+			path, year, snl_info->meta->net, snl_info->meta->sta, snl_info->meta->chan[channel],
+			snl_info->meta->net, snl_info->meta->sta, loc, snl_info->meta->chan[channel], year, yday
+		);
+	}
+
+	return result;
 }
 
 /**
- * @brief
+ * @brief Append the name, size & modification time of the file to the identity, the absent file is also
+ *        marked, then its arrival could be noticed.
  *
+ * @param identity
+ * @param size
+ * @param path
+ * @return int
  */
-void seisdata_release_sac( void )
+static int append_file_identity( char *identity, const size_t size, const char *path )
 {
-	if ( LoadContextSAC )
-		free(LoadContextSAC);
+	const size_t len = strlen(identity);
+	struct stat  st;
 
-	return;
+/* */
+	if ( stat(path, &st) ) {
+		if ( (size_t)snprintf(identity + len, size - len, "|%s:absent", path) >= size - len )
+			return -1;
+	}
+	else if (
+		(size_t)snprintf(
+			identity + len, size - len, "|%s:%lld:%lld.%09ld",
+			path, (long long)st.st_size, (long long)st.st_mtim.tv_sec, (long)st.st_mtim.tv_nsec
+		) >= size - len
+	) {
+		return -1;
+	}
+
+	return 0;
 }
 
 /**
- * @brief
+ * @brief Open the index sidecar of the miniSEED file, it will be (re)built when absent or out of date.
  *
+ * @param path
+ * @return MSINDEX*
  */
-void seisdata_release_ms( void )
+static MSINDEX *open_ms_index( const char *path )
 {
-	if ( LoadContextMS )
-		mstl3_free((MS3TraceList **)&LoadContextMS, 0);
+	char     idxpath[MAX_FILE_NAME] = { 0 };
+	MSINDEX *result = NULL;
 
-	return;
+/* */
+	snprintf(idxpath, sizeof(idxpath), MSINDEX_FILE_NAME_FORMAT, path);
+	if ( !(result = msindex_open( path, idxpath )) ) {
+		fprintf(stderr, "Building the record index %s of the miniSEED file...\n", idxpath);
+		if ( msindex_build( path, idxpath ) >= 0 )
+			result = msindex_open( path, idxpath );
+	}
+
+	return result;
 }
 
 /**
- * @brief
+ * @brief Release the decoded data samples & the record list of the segment, only keep the segment's time information.
  *
+ * @param seg
+ * @param keep_records
  */
-void seisdata_release_tank( void )
+static void release_ms_segment( MS3TraceSeg *seg, const _Bool keep_records )
 {
-	if ( LoadContextTANK )
-		free(LoadContextTANK);
+	MS3RecordPtr *recordptr;
+	MS3RecordPtr *nextrecordptr;
+
+/* */
+	if ( seg->datasamples ) {
+		libmseed_memory.free(seg->datasamples);
+		seg->datasamples = NULL;
+		seg->datasize    = 0;
+		seg->numsamples  = 0;
+	}
+/* */
+	if ( seg->recordlist && !keep_records ) {
+		for ( recordptr = seg->recordlist->first; recordptr; recordptr = nextrecordptr ) {
+			nextrecordptr = recordptr->next;
+			msr3_free(&recordptr->msr);
+			libmseed_memory.free(recordptr);
+		}
+		libmseed_memory.free(seg->recordlist);
+		seg->recordlist = NULL;
+	}
 
 	return;
 }
@@ -0,0 +1,495 @@
+/**
+ * @file stadb.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Compile & read the binary station database. It is compiled from the text station list of postmajor
+ *        or the channel level FDSN station text (the StationXML derived inventory of fdsnws-station with
+ *        'format=text'), then the loading is just one mapping of the file.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+/* */
+#include <sys/mman.h>
+#include <sys/stat.h>
+/* */
+#include <postmajor.h>
+#include <stadb.h>
+
+/* */
+#define MAX_FILE_NAME     512
+#define FDSN_TEXT_HEADER  "#Network|"
+/* */
+typedef struct {
+	STADB_STATION *stations;
+	uint32_t       nstations;
+	uint32_t       capacity;
+} STADB_BUILDER;
+
+/* */
+static STADB_STATION *append_station( STADB_BUILDER * );
+static int            read_stalist_line( STADB_BUILDER *, const char * );
+static int            read_fdsn_text_line( STADB_BUILDER *, double **, const char * );
+static int            write_stadb( STADB_BUILDER *, const char * );
+static uint32_t       hash_snl( const char *, const char *, const char *, const uint32_t );
+static double         parse_epoch( const char * );
+
+/**
+ * @brief Map the database into memory & validate its header. It returns -1 without any message when the file
+ *        is not a database, e.g. the text station list, or -2 when it is a database but can't be used.
+ *
+ * @param path
+ * @param db
+ * @return int
+ */
+int stadb_open( const char *path, STADB **db )
+{
+	STADB              *result = NULL;
+	const STADB_HEADER *header = NULL;
+	void               *ptr    = NULL;
+	char                magic[STADB_MAGIC_LEN];
+	int                 fd;
+	struct stat         st;
+
+/* */
+	if ( (fd = open(path, O_RDONLY)) < 0 )
+		return -1;
+	if (
+		fstat(fd, &st) || read(fd, magic, STADB_MAGIC_LEN) != STADB_MAGIC_LEN ||
+		memcmp(magic, STADB_MAGIC, STADB_MAGIC_LEN)
+	) {
+		close(fd);
+		return -1;
+	}
+	if ( st.st_size < (off_t)sizeof(STADB_HEADER) ) {
+		fprintf(stderr, "ERROR! %s is not a complete postmajor station database!\n", path);
+		close(fd);
+		return -2;
+	}
+	ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if ( ptr == MAP_FAILED ) {
+		fprintf(stderr, "Error mapping %s into memory: %s\n", path, strerror(errno));
+		return -2;
+	}
+/* The stations should fill the whole file exactly */
+	header = (const STADB_HEADER *)ptr;
+	if (
+		header->version != STADB_VERSION || header->file_size != (uint64_t)st.st_size ||
+		header->file_size != sizeof(STADB_HEADER) + (uint64_t)header->nstations * sizeof(STADB_STATION)
+	) {
+		fprintf(stderr, "ERROR! %s is not a valid or complete postmajor station database, it should be compiled again!\n", path);
+		munmap(ptr, (size_t)st.st_size);
+		return -2;
+	}
+/* */
+	if ( !(result = (STADB *)calloc(1, sizeof(STADB))) ) {
+		fprintf(stderr, "ERROR! Out of memory for opening %s\n", path);
+		munmap(ptr, (size_t)st.st_size);
+		return -2;
+	}
+	result->data     = (const char *)ptr;
+	result->size     = (size_t)st.st_size;
+	result->header   = header;
+	result->stations = (const STADB_STATION *)(result->data + sizeof(STADB_HEADER));
+	*db = result;
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param db
+ */
+void stadb_close( STADB *db )
+{
+	if ( db ) {
+		if ( db->data )
+			munmap((void *)db->data, db->size);
+		free(db);
+	}
+
+	return;
+}
+
+/**
+ * @brief Compile the text station list or the FDSN station text into the database, the format is detected
+ *        by the header line of FDSN station text. The duplicated SNL will be skipped.
+ *
+ * @param input
+ * @param output
+ * @return int
+ */
+int stadb_compile( const char *input, const char *output )
+{
+	FILE         *fp     = NULL;
+	char          line[MAX_STR_SIZE];
+	STADB_BUILDER builder;
+	double       *epochs = NULL;
+	_Bool         fdsn   = false;
+	int           result = 0;
+
+/* */
+	if ( !(fp = fopen(input, "r")) ) {
+		fprintf(stderr, "Error opening station list %s\n", input);
+		return -1;
+	}
+/* */
+	memset(&builder, 0, sizeof(builder));
+	while ( fgets(line, sizeof(line) - 1, fp) ) {
+		if ( !strncasecmp(line, FDSN_TEXT_HEADER, strlen(FDSN_TEXT_HEADER)) ) {
+			fdsn = true;
+			continue;
+		}
+	/* */
+		if ( (fdsn ? read_fdsn_text_line( &builder, &epochs, line ) : read_stalist_line( &builder, line )) < 0 ) {
+			result = -1;
+			break;
+		}
+	}
+	fclose(fp);
+/* */
+	if ( !result ) {
+		if ( fdsn ) {
+			for ( register uint32_t i = 0; i < builder.nstations; i++ ) {
+				STADB_STATION *station = &builder.stations[i];
+
+				if ( !station->chan[0][0] || !station->chan[1][0] || !station->chan[2][0] )
+					fprintf(
+						stderr, "WARNING! %s.%s.%s doesn't have all the Z, N & E channels of acceleration, skip it!\n",
+						station->sta, station->net, station->loc
+					);
+			}
+		}
+		result = write_stadb( &builder, output );
+	}
+/* */
+	free(builder.stations);
+	free(epochs);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param builder
+ * @return STADB_STATION*
+ */
+static STADB_STATION *append_station( STADB_BUILDER *builder )
+{
+	STADB_STATION *result = NULL;
+
+/* */
+	if ( builder->nstations == builder->capacity ) {
+		uint32_t       _capacity = builder->capacity ? builder->capacity * 2 : 256;
+		STADB_STATION *_stations = realloc(builder->stations, _capacity * sizeof(STADB_STATION));
+
+		if ( !_stations ) {
+			fprintf(stderr, "ERROR! Out of memory for the station database!\n");
+			return NULL;
+		}
+		builder->stations = _stations;
+		builder->capacity = _capacity;
+	}
+/* */
+	result = &builder->stations[builder->nstations++];
+	memset(result, 0, sizeof(STADB_STATION));
+
+	return result;
+}
+
+/**
+ * @brief Read one line of the text station list, the same fields as postmajor reads.
+ *
+ * @param builder
+ * @param line
+ * @return int
+ */
+static int read_stalist_line( STADB_BUILDER *builder, const char *line )
+{
+	char  sta[MAX_STR_SIZE], net[MAX_STR_SIZE], loc[MAX_STR_SIZE];
+	char  chan[STADB_NUM_CHANNEL][MAX_STR_SIZE];
+	float lat, lon, elev;
+	float gain[STADB_NUM_CHANNEL];
+
+	STADB_STATION *station = NULL;
+
+/* The comment & empty lines */
+	while ( *line == ' ' || *line == '\t' )
+		line++;
+	if ( *line == '#' || *line == '\n' || *line == '\0' )
+		return 0;
+/* */
+	if (
+		sscanf(
+			line, "%s %s %s %f %f %f %s %e %s %e %s %e",
+			sta, net, loc, &lat, &lon, &elev, chan[0], &gain[0], chan[1], &gain[1], chan[2], &gain[2]
+		) != 12
+	) {
+		return 0;
+	}
+	if (
+		strlen(sta) > STADB_CODE_LEN || strlen(net) > STADB_CODE_LEN || strlen(loc) > STADB_CODE_LEN ||
+		strlen(chan[0]) > STADB_CODE_LEN || strlen(chan[1]) > STADB_CODE_LEN || strlen(chan[2]) > STADB_CODE_LEN
+	) {
+		fprintf(stderr, "WARNING! The codes of %s.%s.%s are too long, skip it!\n", sta, net, loc);
+		return 0;
+	}
+/* */
+	if ( !(station = append_station( builder )) )
+		return -1;
+	strcpy(station->sta, sta);
+	strcpy(station->net, net);
+	strcpy(station->loc, loc);
+	for ( register int i = 0; i < STADB_NUM_CHANNEL; i++ ) {
+		strcpy(station->chan[i], chan[i]);
+		station->gain[i] = gain[i];
+	}
+	station->latitude  = lat;
+	station->longitude = lon;
+	station->elevation = elev;
+
+	return 1;
+}
+
+/**
+ * @brief Read one channel line of FDSN station text, 'Network|Station|Location|Channel|Latitude|Longitude|
+ *        Elevation|Depth|Azimuth|Dip|SensorDescription|Scale|ScaleFreq|ScaleUnits|SampleRate|StartTime|EndTime'.
+ *        Only the acceleration channels are taken, the Z, N (or 1) & E (or 2) components are grouped by SNL
+ *        & the gain is the inverse of the scale in gal. The latest epoch of each channel is kept.
+ *
+ * @param builder
+ * @param epochs
+ * @param line
+ * @return int
+ */
+static int read_fdsn_text_line( STADB_BUILDER *builder, double **epochs, const char *line )
+{
+	char           fields[17][MAX_STR_SIZE] = { { 0 } };
+	int            nfields = 0;
+	int            component;
+	double         scale;
+	double         unit;
+	double         epoch;
+	STADB_STATION *station = NULL;
+
+/* */
+	for ( const char *c = line; nfields < 17; c++ ) {
+		size_t len = strlen(fields[nfields]);
+
+		if ( *c == '|' || *c == '\n' || *c == '\r' || *c == '\0' ) {
+			nfields++;
+			if ( *c != '|' )
+				break;
+		}
+		else if ( len < MAX_STR_SIZE - 1 ) {
+			fields[nfields][len] = *c;
+		}
+	}
+	if ( nfields < 16 || line[0] == '#' )
+		return 0;
+/* The acceleration only */
+	if ( !strcasecmp(fields[13], "M/S**2") || !strcasecmp(fields[13], "M/S/S") || !strcasecmp(fields[13], "M/S2") )
+		unit = 100.0;
+	else if ( !strcasecmp(fields[13], "CM/S**2") || !strcasecmp(fields[13], "CM/S/S") || !strcasecmp(fields[13], "GAL") )
+		unit = 1.0;
+	else
+		return 0;
+	if ( (scale = atof(fields[11])) == 0.0 )
+		return 0;
+/* */
+	switch ( toupper(fields[3][strlen(fields[3]) - 1]) ) {
+	case 'Z':
+		component = 0;
+		break;
+	case 'N': case '1':
+		component = 1;
+		break;
+	case 'E': case '2':
+		component = 2;
+		break;
+	default:
+		return 0;
+	}
+	if ( !fields[2][0] )
+		strcpy(fields[2], "--");
+	if (
+		strlen(fields[0]) > STADB_CODE_LEN || strlen(fields[1]) > STADB_CODE_LEN ||
+		strlen(fields[2]) > STADB_CODE_LEN || strlen(fields[3]) > STADB_CODE_LEN
+	) {
+		return 0;
+	}
+/* */
+	for ( register uint32_t i = builder->nstations; i > 0 && !station; i-- ) {
+		if (
+			!strcmp(builder->stations[i - 1].sta, fields[1]) &&
+			!strcmp(builder->stations[i - 1].net, fields[0]) &&
+			!strcmp(builder->stations[i - 1].loc, fields[2])
+		) {
+			station = &builder->stations[i - 1];
+		}
+	}
+	if ( !station ) {
+		uint32_t capacity = builder->capacity;
+		double  *_epochs  = NULL;
+
+		if ( !(station = append_station( builder )) )
+			return -1;
+		if ( capacity != builder->capacity ) {
+			if ( !(_epochs = realloc(*epochs, builder->capacity * STADB_NUM_CHANNEL * sizeof(double))) ) {
+				fprintf(stderr, "ERROR! Out of memory for the station database!\n");
+				return -1;
+			}
+			*epochs = _epochs;
+		}
+		for ( register int i = 0; i < STADB_NUM_CHANNEL; i++ )
+			(*epochs)[(builder->nstations - 1) * STADB_NUM_CHANNEL + i] = -1.0;
+		strcpy(station->sta, fields[1]);
+		strcpy(station->net, fields[0]);
+		strcpy(station->loc, fields[2]);
+	}
+/* The later epoch replaces the earlier one */
+	epoch = parse_epoch( fields[15] );
+	if ( epoch < (*epochs)[(station - builder->stations) * STADB_NUM_CHANNEL + component] )
+		return 0;
+	(*epochs)[(station - builder->stations) * STADB_NUM_CHANNEL + component] = epoch;
+/* */
+	strcpy(station->chan[component], fields[3]);
+	station->gain[component] = unit / scale;
+	station->latitude        = atof(fields[4]);
+	station->longitude       = atof(fields[5]);
+	station->elevation       = atof(fields[6]);
+
+	return 1;
+}
+
+/**
+ * @brief Write the stations, the file is written to a temporary name & then renamed. The stations without
+ *        all the channels or with duplicated SNL are skipped, the duplicates are found thru the hash of SNL.
+ *
+ * @param builder
+ * @param path
+ * @return int
+ */
+static int write_stadb( STADB_BUILDER *builder, const char *path )
+{
+	char          tmppath[MAX_FILE_NAME + 32];
+	STADB_HEADER  header;
+	uint32_t     *hash   = NULL;
+	uint32_t     *next   = NULL;
+	uint32_t      size   = builder->nstations * 2 + 1;
+	uint32_t      count  = 0;
+	FILE         *fp     = NULL;
+	_Bool         failed = false;
+
+/* */
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, STADB_MAGIC, STADB_MAGIC_LEN);
+	header.version = STADB_VERSION;
+	if (
+		!(hash = (uint32_t *)calloc(size, sizeof(uint32_t))) ||
+		!(next = (uint32_t *)calloc(builder->nstations + 1, sizeof(uint32_t)))
+	) {
+		fprintf(stderr, "ERROR! Out of memory for the station database!\n");
+		free(hash);
+		return -1;
+	}
+/* Compact the valid stations & link them into the hash slots, each slot is the index+1 of the first one */
+	for ( register uint32_t i = 0; i < builder->nstations; i++ ) {
+		STADB_STATION *station = &builder->stations[i];
+		uint32_t       slot    = hash_snl( station->sta, station->net, station->loc, size );
+		_Bool          dup     = false;
+
+		if ( !station->chan[0][0] || !station->chan[1][0] || !station->chan[2][0] )
+			continue;
+		for ( uint32_t j = hash[slot]; j && !dup; j = next[j] )
+			dup = !strcmp(builder->stations[j - 1].sta, station->sta) &&
+				!strcmp(builder->stations[j - 1].net, station->net) &&
+				!strcmp(builder->stations[j - 1].loc, station->loc);
+		if ( dup ) {
+			fprintf(stderr, "WARNING! %s.%s.%s is duplicated, skip it!\n", station->sta, station->net, station->loc);
+			continue;
+		}
+	/* */
+		builder->stations[count] = *station;
+		next[count + 1]          = hash[slot];
+		hash[slot]               = ++count;
+	}
+	free(hash);
+	free(next);
+	header.nstations = count;
+	header.file_size = sizeof(STADB_HEADER) + (uint64_t)count * sizeof(STADB_STATION);
+/* */
+	snprintf(tmppath, sizeof(tmppath), "%s.%ld.tmp", path, (long)getpid());
+	if ( !(fp = fopen(tmppath, "wb")) ) {
+		fprintf(stderr, "ERROR! Cannot create the station database %s!\n", tmppath);
+		return -1;
+	}
+	failed = fwrite(&header, sizeof(header), 1, fp) != 1;
+	if ( !failed && count )
+		failed = fwrite(builder->stations, sizeof(STADB_STATION), count, fp) != count;
+	if ( fclose(fp) || failed || rename(tmppath, path) ) {
+		fprintf(stderr, "ERROR! Cannot write the station database %s!\n", path);
+		remove(tmppath);
+		return -1;
+	}
+
+	return (int)count;
+}
+
+/**
+ * @brief
+ *
+ * @param sta
+ * @param net
+ * @param loc
+ * @param size
+ * @return uint32_t
+ */
+static uint32_t hash_snl( const char *sta, const char *net, const char *loc, const uint32_t size )
+{
+	uint32_t result = 2166136261u;
+
+/* */
+	for ( int i = 0; i < STADB_CODE_LEN && sta[i]; i++ )
+		result = (result ^ (uint8_t)sta[i]) * 16777619u;
+	result = (result ^ '.') * 16777619u;
+	for ( int i = 0; i < STADB_CODE_LEN && net[i]; i++ )
+		result = (result ^ (uint8_t)net[i]) * 16777619u;
+	result = (result ^ '.') * 16777619u;
+	for ( int i = 0; i < STADB_CODE_LEN && loc[i]; i++ )
+		result = (result ^ (uint8_t)loc[i]) * 16777619u;
+
+	return result % size;
+}
+
+/**
+ * @brief Parse the ISO time of FDSN station text into seconds, only for comparing the epochs.
+ *
+ * @param iso
+ * @return double
+ */
+static double parse_epoch( const char *iso )
+{
+	int    year = 0, month = 0, day = 0, hour = 0, min = 0;
+	double sec  = 0.0;
+
+/* */
+	sscanf(iso, "%d-%d-%dT%d:%d:%lf", &year, &month, &day, &hour, &min, &sec);
+
+	return ((((year * 12.0 + month) * 31.0 + day) * 24.0 + hour) * 60.0 + min) * 60.0 + sec;
+}
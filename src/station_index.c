@@ -0,0 +1,449 @@
+/**
+ * @file station_index.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief The spatial index over the station list, an implicit k-d tree of the station coordinates. The
+ *        subtrees are pruned with the lower bound of coor2distf over their bounding boxes, so the results
+ *        are exactly the same as scanning all the stations with coor2distf.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+/* */
+#include <postmajor.h>
+#include <station_index.h>
+
+/* */
+typedef struct {
+	int    snl;
+	double dist;
+} STATION_DIST;
+
+/* */
+static void   build_tree( STATION_INDEX_NODE *, const int, const int, const int );
+static void   search_radius(
+	const STATION_INDEX_NODE *, const int, const int, const double, const double, const double, STATION_DIST *, int *
+);
+static void   search_nearest(
+	const STATION_INDEX_NODE *, const int, const int, const int, const double, const double, STATION_DIST *, const int, int *
+);
+static void   heap_push( STATION_DIST *, const int, int *, const STATION_DIST );
+static void   output_dists( STATION_DIST *, const int, int *, double * );
+static double lower_bound_dist( const STATION_INDEX_NODE *, const double, const double );
+static double lon_scale( const double );
+static int    compare_lon( const void *, const void * );
+static int    compare_lat( const void *, const void * );
+static int    compare_dist( const void *, const void * );
+
+/**
+ * @brief Build the index over the coordinates of all the stations.
+ *
+ * @param metas
+ * @param totalsnl
+ * @return STATION_INDEX*
+ */
+STATION_INDEX *station_index_build( const SNL_META *metas, const int totalsnl )
+{
+	STATION_INDEX *result = NULL;
+
+/* */
+	if (
+		!(result = (STATION_INDEX *)calloc(1, sizeof(STATION_INDEX))) ||
+		(totalsnl > 0 && !(result->nodes = (STATION_INDEX_NODE *)calloc(totalsnl, sizeof(STATION_INDEX_NODE))))
+	) {
+		fprintf(stderr, "ERROR! Out of memory for the station index!\n");
+		free(result);
+		return NULL;
+	}
+/* */
+	for ( register int i = 0; i < totalsnl; i++ ) {
+		result->nodes[i].longitude = metas[i].longitude;
+		result->nodes[i].latitude  = metas[i].latitude;
+		result->nodes[i].snl       = i;
+	}
+	result->nnodes = totalsnl;
+	build_tree( result->nodes, 0, totalsnl, 0 );
+
+	return result;
+}
+
+/**
+ * @brief Find all the stations within the radius (km) of the epicenter, they are ordered by the distance.
+ *        The buffers should be able to hold all the stations, the distances might be NULL.
+ *
+ * @param index
+ * @param lon
+ * @param lat
+ * @param radius
+ * @param snls
+ * @param dists
+ * @return int
+ */
+int station_index_radius(
+	const STATION_INDEX *index, const double lon, const double lat, const double radius, int *snls, double *dists
+) {
+	STATION_DIST *found = NULL;
+	int           count = 0;
+
+/* */
+	if ( index->nnodes && !(found = (STATION_DIST *)malloc(index->nnodes * sizeof(STATION_DIST))) ) {
+		fprintf(stderr, "ERROR! Out of memory for the station index query!\n");
+		return -1;
+	}
+	search_radius( index->nodes, 0, index->nnodes, lon, lat, radius, found, &count );
+	qsort(found, count, sizeof(STATION_DIST), compare_dist);
+	output_dists( found, count, snls, dists );
+	free(found);
+
+	return count;
+}
+
+/**
+ * @brief Find the nearest N stations of the epicenter, they are ordered by the distance. The whole station
+ *        list in the distance order is just the N of all the stations.
+ *
+ * @param index
+ * @param lon
+ * @param lat
+ * @param nearest
+ * @param snls
+ * @param dists
+ * @return int
+ */
+int station_index_nearest(
+	const STATION_INDEX *index, const double lon, const double lat, const int nearest, int *snls, double *dists
+) {
+	const int     n     = nearest < index->nnodes ? nearest : index->nnodes;
+	STATION_DIST *heap  = NULL;
+	int           count = 0;
+
+/* */
+	if ( n <= 0 )
+		return 0;
+	if ( !(heap = (STATION_DIST *)malloc(n * sizeof(STATION_DIST))) ) {
+		fprintf(stderr, "ERROR! Out of memory for the station index query!\n");
+		return -1;
+	}
+	search_nearest( index->nodes, 0, index->nnodes, 0, lon, lat, heap, n, &count );
+	qsort(heap, count, sizeof(STATION_DIST), compare_dist);
+	output_dists( heap, count, snls, dists );
+	free(heap);
+
+	return count;
+}
+
+/**
+ * @brief
+ *
+ * @param index
+ */
+void station_index_free( STATION_INDEX *index )
+{
+	if ( index ) {
+		free(index->nodes);
+		free(index);
+	}
+
+	return;
+}
+
+/**
+ * @brief  Transforms the coordinate(latitude & longitude) into distance(unit: km)
+ *
+ * @param elon
+ * @param elat
+ * @param slon
+ * @param slat
+ * @return double
+ */
+double coor2distf( const double elon, const double elat, const double slon, const double slat )
+{
+	const double avlat = (elat + slat) * 0.5;
+
+	double a = lon_scale( avlat );
+	double b = 1.843404 + avlat * (-6.93799e-5 + avlat * (8.79993e-6 + avlat * (-6.47527e-8)));
+
+	a *= (slon - elon) * 60.0;
+	b *= (slat - elat) * 60.0;
+
+	return sqrt(a * a + b * b);
+}
+
+/**
+ * @brief Build the subtree of range [lo, hi), the splitting axis is alternated between longitude & latitude.
+ *
+ * @param nodes
+ * @param lo
+ * @param hi
+ * @param depth
+ */
+static void build_tree( STATION_INDEX_NODE *nodes, const int lo, const int hi, const int depth )
+{
+	const int mid = (lo + hi) / 2;
+
+	float minlon, maxlon, minlat, maxlat;
+
+/* */
+	if ( lo >= hi )
+		return;
+/* */
+	minlon = maxlon = nodes[lo].longitude;
+	minlat = maxlat = nodes[lo].latitude;
+	for ( register int i = lo + 1; i < hi; i++ ) {
+		if ( nodes[i].longitude < minlon )
+			minlon = nodes[i].longitude;
+		if ( nodes[i].longitude > maxlon )
+			maxlon = nodes[i].longitude;
+		if ( nodes[i].latitude < minlat )
+			minlat = nodes[i].latitude;
+		if ( nodes[i].latitude > maxlat )
+			maxlat = nodes[i].latitude;
+	}
+/* */
+	qsort(nodes + lo, hi - lo, sizeof(STATION_INDEX_NODE), depth & 1 ? compare_lat : compare_lon);
+	nodes[mid].minlon = minlon;
+	nodes[mid].maxlon = maxlon;
+	nodes[mid].minlat = minlat;
+	nodes[mid].maxlat = maxlat;
+/* */
+	build_tree( nodes, lo, mid, depth + 1 );
+	build_tree( nodes, mid + 1, hi, depth + 1 );
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param nodes
+ * @param lo
+ * @param hi
+ * @param lon
+ * @param lat
+ * @param radius
+ * @param found
+ * @param count
+ */
+static void search_radius(
+	const STATION_INDEX_NODE *nodes, const int lo, const int hi, const double lon, const double lat, const double radius,
+	STATION_DIST *found, int *count
+) {
+	const int                 mid  = (lo + hi) / 2;
+	const STATION_INDEX_NODE *node = nodes + mid;
+
+	double dist;
+
+/* */
+	if ( lo >= hi || lower_bound_dist( node, lon, lat ) > radius )
+		return;
+/* */
+	if ( (dist = coor2distf( lon, lat, node->longitude, node->latitude )) <= radius ) {
+		found[*count].snl  = node->snl;
+		found[*count].dist = dist;
+		(*count)++;
+	}
+/* */
+	search_radius( nodes, lo, mid, lon, lat, radius, found, count );
+	search_radius( nodes, mid + 1, hi, lon, lat, radius, found, count );
+
+	return;
+}
+
+/**
+ * @brief Search the nearest stations with a max heap of the current candidates, the nearer child is
+ *        visited first to shrink the heap top as soon as possible.
+ *
+ * @param nodes
+ * @param lo
+ * @param hi
+ * @param depth
+ * @param lon
+ * @param lat
+ * @param heap
+ * @param nearest
+ * @param count
+ */
+static void search_nearest(
+	const STATION_INDEX_NODE *nodes, const int lo, const int hi, const int depth, const double lon, const double lat,
+	STATION_DIST *heap, const int nearest, int *count
+) {
+	const int                 mid  = (lo + hi) / 2;
+	const STATION_INDEX_NODE *node = nodes + mid;
+
+	STATION_DIST candidate;
+	_Bool        lower;
+
+/* */
+	if ( lo >= hi || (*count == nearest && lower_bound_dist( node, lon, lat ) > heap[0].dist) )
+		return;
+/* */
+	candidate.snl  = node->snl;
+	candidate.dist = coor2distf( lon, lat, node->longitude, node->latitude );
+	heap_push( heap, nearest, count, candidate );
+/* */
+	lower = depth & 1 ? lat < node->latitude : lon < node->longitude;
+	search_nearest( nodes, lower ? lo : mid + 1, lower ? mid : hi, depth + 1, lon, lat, heap, nearest, count );
+	search_nearest( nodes, lower ? mid + 1 : lo, lower ? hi : mid, depth + 1, lon, lat, heap, nearest, count );
+
+	return;
+}
+
+/**
+ * @brief Push the candidate into the max heap, the top will be replaced when the heap is full.
+ *
+ * @param heap
+ * @param nearest
+ * @param count
+ * @param candidate
+ */
+static void heap_push( STATION_DIST *heap, const int nearest, int *count, const STATION_DIST candidate )
+{
+	STATION_DIST tmp;
+	int          i;
+
+/* */
+	if ( *count < nearest ) {
+		for ( i = (*count)++; i > 0 && compare_dist( &heap[(i - 1) / 2], &candidate ) < 0; i = (i - 1) / 2 )
+			heap[i] = heap[(i - 1) / 2];
+		heap[i] = candidate;
+		return;
+	}
+/* */
+	if ( compare_dist( &candidate, &heap[0] ) >= 0 )
+		return;
+	heap[0] = candidate;
+	for ( i = 0; ; ) {
+		int largest = i;
+
+		if ( 2 * i + 1 < nearest && compare_dist( &heap[2 * i + 1], &heap[largest] ) > 0 )
+			largest = 2 * i + 1;
+		if ( 2 * i + 2 < nearest && compare_dist( &heap[2 * i + 2], &heap[largest] ) > 0 )
+			largest = 2 * i + 2;
+		if ( largest == i )
+			break;
+	/* */
+		tmp           = heap[i];
+		heap[i]       = heap[largest];
+		heap[largest] = tmp;
+		i             = largest;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param found
+ * @param count
+ * @param snls
+ * @param dists
+ */
+static void output_dists( STATION_DIST *found, const int count, int *snls, double *dists )
+{
+	for ( register int i = 0; i < count; i++ ) {
+		snls[i] = found[i].snl;
+		if ( dists )
+			dists[i] = found[i].dist;
+	}
+
+	return;
+}
+
+/**
+ * @brief The lower bound of coor2distf from the epicenter to any station inside the bounding box. The latitude
+ *        scale is bounded by its global minimum & the longitude scale, which is unimodal over the latitude, is
+ *        bounded by the smaller one of the box edges.
+ *
+ * @param node
+ * @param lon
+ * @param lat
+ * @return double
+ */
+static double lower_bound_dist( const STATION_INDEX_NODE *node, const double lon, const double lat )
+{
+	const double dlon = lon < node->minlon ? node->minlon - lon : lon > node->maxlon ? lon - node->maxlon : 0.0;
+	const double dlat = lat < node->minlat ? node->minlat - lat : lat > node->maxlat ? lat - node->maxlat : 0.0;
+
+	double a = fmin(lon_scale( (lat + node->minlat) * 0.5 ), lon_scale( (lat + node->maxlat) * 0.5 ));
+	double b = STATION_INDEX_MIN_LAT_SCALE;
+
+/* The scale of longitude near the poles might be negative, it is squared in coor2distf */
+	if ( a < 0.0 )
+		a = 0.0;
+	a *= dlon * 60.0;
+	b *= dlat * 60.0;
+
+	return sqrt(a * a + b * b);
+}
+
+/**
+ * @brief The longitude scale (km per arc minute) of coor2distf at the average latitude.
+ *
+ * @param avlat
+ * @return double
+ */
+static double lon_scale( const double avlat )
+{
+	return 1.840708 + avlat * (.0015269 + avlat * (-.00034 + avlat * (1.02337e-6)));
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_lon( const void *a, const void *b )
+{
+	const STATION_INDEX_NODE *_a = (const STATION_INDEX_NODE *)a;
+	const STATION_INDEX_NODE *_b = (const STATION_INDEX_NODE *)b;
+
+	if ( _a->longitude != _b->longitude )
+		return _a->longitude < _b->longitude ? -1 : 1;
+
+	return _a->snl - _b->snl;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_lat( const void *a, const void *b )
+{
+	const STATION_INDEX_NODE *_a = (const STATION_INDEX_NODE *)a;
+	const STATION_INDEX_NODE *_b = (const STATION_INDEX_NODE *)b;
+
+	if ( _a->latitude != _b->latitude )
+		return _a->latitude < _b->latitude ? -1 : 1;
+
+	return _a->snl - _b->snl;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_dist( const void *a, const void *b )
+{
+	const STATION_DIST *_a = (const STATION_DIST *)a;
+	const STATION_DIST *_b = (const STATION_DIST *)b;
+
+	if ( _a->dist != _b->dist )
+		return _a->dist < _b->dist ? -1 : 1;
+
+	return _a->snl - _b->snl;
+}
@@ -0,0 +1,420 @@
+/**
+ * @file tank.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Read the Earthworm tank player files of TRACEBUF2 packets. The tank will be mapped into
+ *        memory & indexed by SCNL in one scan, then the samples of each SCNL can be converted into
+ *        the float buffer directly from the mapped packets.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+/* */
+#include <sys/mman.h>
+#include <sys/stat.h>
+/* */
+#include <trace_buf.h>
+#include <tank.h>
+
+/* */
+static int      parse_packet_header( const char *, const size_t, TRACE2_HEADER * );
+static int      fetch_sample_size( const char * );
+static uint32_t hash_scnl( const char *, const char *, const char *, const char * );
+static int      compare_packet( const void *, const void * );
+static void     convert_samples( const char *, const char *, const int, float * );
+
+/**
+ * @brief Map the tank into memory & index all the TRACEBUF2 packets by SCNL.
+ *
+ * @param path
+ * @return TANK*
+ */
+TANK *tank_open( const char *path )
+{
+	TANK          *result  = NULL;
+	TANK_SCNL     *scnl    = NULL;
+	void          *ptr     = NULL;
+	uint32_t       maxscnl = 0;
+	uint32_t       maxpkt  = 0;
+	uint32_t       slot;
+	size_t         offset  = 0;
+	int            pktsize;
+	int            fd;
+	struct stat    st;
+	TRACE2_HEADER  trh;
+
+/* */
+	if ( (fd = open(path, O_RDONLY)) < 0 ) {
+		fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+		return NULL;
+	}
+	if ( fstat(fd, &st) || st.st_size <= 0 ) {
+		fprintf(stderr, "Error getting the status of %s\n", path);
+		close(fd);
+		return NULL;
+	}
+	ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if ( ptr == MAP_FAILED ) {
+		fprintf(stderr, "Error mapping %s into memory: %s\n", path, strerror(errno));
+		return NULL;
+	}
+	madvise(ptr, (size_t)st.st_size, MADV_SEQUENTIAL);
+/* */
+	if ( !(result = (TANK *)calloc(1, sizeof(TANK))) ) {
+		fprintf(stderr, "ERROR! Out of memory for the index of %s\n", path);
+		munmap(ptr, (size_t)st.st_size);
+		return NULL;
+	}
+	result->data = (const char *)ptr;
+	result->size = (size_t)st.st_size;
+
+/* Go thru all the packets, only the header will be parsed */
+	while ( offset < result->size ) {
+		if ( (pktsize = parse_packet_header( result->data + offset, result->size - offset, &trh )) <= 0 ) {
+			fprintf(stderr, "WARNING! Broken TRACEBUF2 packet at offset %zu of %s, skip the rest!\n", offset, path);
+			break;
+		}
+	/* Find the SCNL in the hash table, or append the new one */
+		slot = hash_scnl( trh.sta, trh.chan, trh.net, trh.loc ) % TANK_HASH_SIZE;
+		for ( scnl = result->hash[slot] ? result->scnls + result->hash[slot] - 1 : NULL; scnl; ) {
+			if (
+				!strcmp(scnl->sta, trh.sta) && !strcmp(scnl->chan, trh.chan) &&
+				!strcmp(scnl->net, trh.net) && !strcmp(scnl->loc, trh.loc)
+			) {
+				break;
+			}
+			scnl = scnl->next ? result->scnls + scnl->next - 1 : NULL;
+		}
+		if ( !scnl ) {
+			if ( result->nscnls >= maxscnl ) {
+				maxscnl = maxscnl ? maxscnl * 2 : 256;
+				if ( !(scnl = (TANK_SCNL *)realloc(result->scnls, maxscnl * sizeof(TANK_SCNL))) )
+					goto fail;
+				result->scnls = scnl;
+			}
+			scnl = result->scnls + result->nscnls++;
+			memset(scnl, 0, sizeof(TANK_SCNL));
+			strcpy(scnl->sta, trh.sta);
+			strcpy(scnl->chan, trh.chan);
+			strcpy(scnl->net, trh.net);
+			strcpy(scnl->loc, trh.loc);
+			scnl->samprate = trh.samprate;
+			scnl->earliest = trh.starttime;
+			scnl->latest   = trh.endtime;
+			scnl->next     = result->hash[slot];
+			result->hash[slot] = result->nscnls;
+		}
+	/* */
+		if ( result->npackets >= maxpkt ) {
+			maxpkt = maxpkt ? maxpkt * 2 : 4096;
+			if ( !(ptr = realloc(result->packets, maxpkt * sizeof(TANK_PACKET))) )
+				goto fail;
+			result->packets = (TANK_PACKET *)ptr;
+		}
+		result->packets[result->npackets++] = (TANK_PACKET){
+			.offset = offset, .starttime = trh.starttime, .endtime = trh.endtime,
+			.scnl = (uint32_t)(scnl - result->scnls), .nsamp = trh.nsamp
+		};
+	/* */
+		if ( trh.starttime < scnl->earliest )
+			scnl->earliest = trh.starttime;
+		if ( trh.endtime > scnl->latest )
+			scnl->latest = trh.endtime;
+	/* */
+		offset += pktsize;
+	}
+
+/* Group the packets by SCNL, then by time */
+	if ( result->npackets ) {
+		qsort(result->packets, result->npackets, sizeof(TANK_PACKET), compare_packet);
+		for ( uint32_t i = 0; i < result->npackets; i++ ) {
+			scnl = result->scnls + result->packets[i].scnl;
+			if ( !scnl->count++ )
+				scnl->first = i;
+		}
+	}
+
+	return result;
+
+fail:
+	fprintf(stderr, "ERROR! Out of memory for the index of %s\n", path);
+	tank_close( result );
+	return NULL;
+}
+
+/**
+ * @brief Find the SCNL in the index of tank.
+ *
+ * @param tank
+ * @param sta
+ * @param chan
+ * @param net
+ * @param loc
+ * @return const TANK_SCNL*
+ */
+const TANK_SCNL *tank_scnl_find( const TANK *tank, const char *sta, const char *chan, const char *net, const char *loc )
+{
+	const TANK_SCNL *result = NULL;
+	uint32_t         next;
+
+/* */
+	next = tank->hash[hash_scnl( sta, chan, net, loc ) % TANK_HASH_SIZE];
+	while ( next ) {
+		result = tank->scnls + next - 1;
+		if (
+			!strcmp(result->sta, sta) && !strcmp(result->chan, chan) &&
+			!strcmp(result->net, net) && !strcmp(result->loc, loc)
+		) {
+			return result;
+		}
+		next = result->next;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Convert the samples of the SCNL into the buffer which begins at the start time, the positions
+ *        not covered by any packet will be left untouched.
+ *
+ * @param tank
+ * @param scnl
+ * @param starttime
+ * @param buffer
+ * @param npts
+ * @param gaps The number of gaps between packets.
+ * @return int The number of filled samples.
+ */
+int tank_scnl_fill(
+	const TANK *tank, const TANK_SCNL *scnl, const double starttime, float *buffer, const int npts, int *gaps
+) {
+	const TANK_PACKET *packet  = tank->packets + scnl->first;
+	const TANK_PACKET *end     = packet + scnl->count;
+	const char        *data;
+	double             lastend = 0.0;
+	int                result  = 0;
+	int                _gaps   = 0;
+	int                pos;
+	int                skip;
+	int                nsamp;
+	TRACE2_HEADER      trh;
+
+/* */
+	for ( ; packet < end; packet++ ) {
+	/* The packets are sorted by time, so any jump over 1.5 sample period is a gap */
+		if ( lastend > 0.0 && (packet->starttime - lastend) * scnl->samprate > 1.5 )
+			_gaps++;
+		if ( packet->endtime > lastend )
+			lastend = packet->endtime;
+	/* */
+		pos   = (int)((packet->starttime - starttime) * scnl->samprate + 0.5);
+		skip  = pos < 0 ? -pos : 0;
+		nsamp = packet->nsamp - skip;
+		if ( pos + skip + nsamp > npts )
+			nsamp = npts - pos - skip;
+		if ( nsamp <= 0 )
+			continue;
+	/* Samples are converted from the mapped packet directly */
+		data = tank->data + packet->offset;
+		memcpy(&trh, data, sizeof(TRACE2_HEADER));
+		data += sizeof(TRACE2_HEADER) + (size_t)skip * fetch_sample_size( trh.datatype );
+		convert_samples( data, trh.datatype, nsamp, buffer + pos + skip );
+		result += nsamp;
+	}
+/* */
+	if ( gaps )
+		*gaps = _gaps;
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param tank
+ */
+void tank_close( TANK *tank )
+{
+	if ( tank ) {
+		if ( tank->data )
+			munmap((void *)tank->data, tank->size);
+		free(tank->scnls);
+		free(tank->packets);
+		free(tank);
+	}
+
+	return;
+}
+
+/**
+ * @brief Parse & check the header of the packet at the pointer.
+ *
+ * @param ptr
+ * @param remain
+ * @param trh
+ * @return int The total size of the packet, or zero for the broken one.
+ */
+static int parse_packet_header( const char *ptr, const size_t remain, TRACE2_HEADER *trh )
+{
+	int samplesize;
+	int result;
+
+/* */
+	if ( remain < sizeof(TRACE2_HEADER) )
+		return 0;
+	memcpy(trh, ptr, sizeof(TRACE2_HEADER));
+/* The header of packet is written in the byte order of its data type */
+	if ( (trh->datatype[0] == 's' || trh->datatype[0] == 't') != (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__) ) {
+		uint64_t tmp;
+		trh->pinno = (int32_t)__builtin_bswap32((uint32_t)trh->pinno);
+		trh->nsamp = (int32_t)__builtin_bswap32((uint32_t)trh->nsamp);
+		memcpy(&tmp, &trh->starttime, 8); tmp = __builtin_bswap64(tmp); memcpy(&trh->starttime, &tmp, 8);
+		memcpy(&tmp, &trh->endtime, 8);   tmp = __builtin_bswap64(tmp); memcpy(&trh->endtime, &tmp, 8);
+		memcpy(&tmp, &trh->samprate, 8);  tmp = __builtin_bswap64(tmp); memcpy(&trh->samprate, &tmp, 8);
+	}
+/* */
+	if ( !(samplesize = fetch_sample_size( trh->datatype )) || trh->nsamp <= 0 || !(trh->samprate > 0.0) )
+		return 0;
+	result = sizeof(TRACE2_HEADER) + trh->nsamp * samplesize;
+	if ( result > MAX_TRACEBUF_SIZ || (size_t)result > remain )
+		return 0;
+/* Make sure all the strings are terminated, and the old TRACEBUF packet has no location */
+	trh->sta[TRACE2_STA_LEN - 1]   = '\0';
+	trh->net[TRACE2_NET_LEN - 1]   = '\0';
+	trh->chan[TRACE2_CHAN_LEN - 1] = '\0';
+	trh->loc[TRACE2_LOC_LEN - 1]   = '\0';
+	if ( trh->version[0] != TRACE2_VERSION0 || !trh->loc[0] )
+		strcpy(trh->loc, LOC_NULL_STRING);
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param datatype
+ * @return int
+ */
+static int fetch_sample_size( const char *datatype )
+{
+	switch ( datatype[0] ) {
+	case 's': case 'i':
+		return datatype[1] == '2' ? 2 : datatype[1] == '4' ? 4 : 0;
+	case 't': case 'f':
+		return datatype[1] == '4' ? 4 : datatype[1] == '8' ? 8 : 0;
+	default:
+		return 0;
+	}
+}
+
+/**
+ * @brief Convert the samples of any data type & byte order into float.
+ *
+ * @param data
+ * @param datatype
+ * @param nsamp
+ * @param output
+ */
+static void convert_samples( const char *data, const char *datatype, const int nsamp, float *output )
+{
+	const int swap = (datatype[0] == 's' || datatype[0] == 't') != (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__);
+	uint16_t  u16;
+	uint32_t  u32;
+	uint64_t  u64;
+	float     f32;
+	double    f64;
+
+/* */
+	switch ( fetch_sample_size( datatype ) * ((datatype[0] == 't' || datatype[0] == 'f') ? -1 : 1) ) {
+	case 2:
+		for ( int i = 0; i < nsamp; i++, data += 2 ) {
+			memcpy(&u16, data, 2);
+			output[i] = (int16_t)(swap ? __builtin_bswap16(u16) : u16);
+		}
+		break;
+	case 4:
+		for ( int i = 0; i < nsamp; i++, data += 4 ) {
+			memcpy(&u32, data, 4);
+			output[i] = (int32_t)(swap ? __builtin_bswap32(u32) : u32);
+		}
+		break;
+	case -4:
+		for ( int i = 0; i < nsamp; i++, data += 4 ) {
+			memcpy(&u32, data, 4);
+			u32 = swap ? __builtin_bswap32(u32) : u32;
+			memcpy(&f32, &u32, 4);
+			output[i] = f32;
+		}
+		break;
+	case -8:
+		for ( int i = 0; i < nsamp; i++, data += 8 ) {
+			memcpy(&u64, data, 8);
+			u64 = swap ? __builtin_bswap64(u64) : u64;
+			memcpy(&f64, &u64, 8);
+			output[i] = f64;
+		}
+		break;
+	default:
+		break;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param sta
+ * @param chan
+ * @param net
+ * @param loc
+ * @return uint32_t
+ */
+static uint32_t hash_scnl( const char *sta, const char *chan, const char *net, const char *loc )
+{
+	register uint32_t result = 2166136261u;
+	const char       *codes[] = { sta, chan, net, loc };
+
+/* */
+	for ( int i = 0; i < 4; i++ ) {
+		for ( const char *c = codes[i]; *c; c++ ) {
+			result ^= (uint8_t)*c;
+			result *= 16777619u;
+		}
+		result ^= '.';
+		result *= 16777619u;
+	}
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param a
+ * @param b
+ * @return int
+ */
+static int compare_packet( const void *a, const void *b )
+{
+	const TANK_PACKET *pa = (const TANK_PACKET *)a;
+	const TANK_PACKET *pb = (const TANK_PACKET *)b;
+
+/* */
+	if ( pa->scnl != pb->scnl )
+		return pa->scnl < pb->scnl ? -1 : 1;
+	if ( pa->starttime != pb->starttime )
+		return pa->starttime < pb->starttime ? -1 : 1;
+
+	return pa->offset < pb->offset ? -1 : (pa->offset > pb->offset);
+}
@@ -0,0 +1,500 @@
+/**
+ * @file tararchive.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Read the tar or tar.bz2 archive in one pass, the bzip2 stream is decompressed in process and
+ *        each regular file member is kept in its own memory buffer, indexed by its base name. Then
+ *        there is no need to extract the archive into temporary files.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+/* */
+#include <bzlib.h>
+/* */
+#include <tararchive.h>
+
+/* */
+#define TAR_READ_BUFFER_SIZE  1048576
+#define TAR_DECOMP_BUFFER_SIZE 262144
+/* */
+typedef enum {
+	TAR_STATE_HEADER,
+	TAR_STATE_DATA,
+	TAR_STATE_PADDING,
+	TAR_STATE_END
+} TAR_STATE;
+
+/* */
+typedef enum {
+	TAR_TARGET_MEMBER,
+	TAR_TARGET_LONGNAME,
+	TAR_TARGET_PAX,
+	TAR_TARGET_SKIP
+} TAR_TARGET;
+
+/*
+ * The state of the stream parser, the decompressed bytes are fed into it chunk by chunk
+ */
+typedef struct {
+	TAR_ARCHIVE *archive;
+	TAR_STATE    state;
+	TAR_TARGET   target;
+	char         header[TAR_BLOCK_SIZE];
+	size_t       filled;
+	char        *buffer;    /* destination of the data in the current member */
+	size_t       size;      /* size of the data in the current member */
+	size_t       remain;    /* bytes remain of the data or the padding */
+	char         name[TAR_MAX_NAME];
+	_Bool        has_name;  /* the name of next member has been set by GNU long name or pax header */
+	uint32_t     maxmembers;
+} TAR_STREAM;
+
+/* */
+static int      feed_stream( TAR_STREAM *, const char *, size_t );
+static int      parse_header( TAR_STREAM * );
+static int      finish_data( TAR_STREAM * );
+static int      add_member( TAR_STREAM *, const char * );
+static size_t   parse_octal( const char *, const int );
+static uint32_t hash_name( const char * );
+
+/**
+ * @brief Read the whole archive into memory, the bzip2 compressed archive is detected by its magic.
+ *
+ * @param path
+ * @return TAR_ARCHIVE*
+ */
+TAR_ARCHIVE *tar_archive_open( const char *path )
+{
+	FILE      *fd      = NULL;
+	char      *inbuf   = NULL;
+	char      *outbuf  = NULL;
+	size_t     nread   = 0;
+	_Bool      bzipped = 0;
+	_Bool      bzinit  = 0;
+	_Bool      first   = 1;
+	int        ret     = BZ_OK;
+	bz_stream  bzs;
+	TAR_STREAM stream;
+
+/* */
+	if ( !(fd = fopen(path, "rb")) ) {
+		fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+		return NULL;
+	}
+	memset(&stream, 0, sizeof(TAR_STREAM));
+	if (
+		!(stream.archive = (TAR_ARCHIVE *)calloc(1, sizeof(TAR_ARCHIVE))) ||
+		!(inbuf = (char *)malloc(TAR_READ_BUFFER_SIZE)) ||
+		!(outbuf = (char *)malloc(TAR_DECOMP_BUFFER_SIZE))
+	) {
+		fprintf(stderr, "ERROR! Out of memory for reading the archive %s\n", path);
+		goto fail;
+	}
+	stream.state = TAR_STATE_HEADER;
+
+/* */
+	memset(&bzs, 0, sizeof(bz_stream));
+	while ( stream.state != TAR_STATE_END && (nread = fread(inbuf, 1, TAR_READ_BUFFER_SIZE, fd)) > 0 ) {
+	/* The first chunk decides the compression */
+		if ( first ) {
+			bzipped = nread >= 3 && !memcmp(inbuf, "BZh", 3);
+			first   = 0;
+		}
+	/* */
+		if ( !bzipped ) {
+			if ( feed_stream( &stream, inbuf, nread ) )
+				goto fail;
+			continue;
+		}
+	/* Decompress the chunk, the concatenated bzip2 streams (e.g. from pbzip2) are also supported */
+		bzs.next_in  = inbuf;
+		bzs.avail_in = (unsigned int)nread;
+		while ( bzs.avail_in > 0 && stream.state != TAR_STATE_END ) {
+			if ( !bzinit ) {
+				if ( BZ2_bzDecompressInit(&bzs, 0, 0) != BZ_OK ) {
+					fprintf(stderr, "Error initializing the bzip2 decompression of %s\n", path);
+					goto fail;
+				}
+				bzinit = 1;
+			}
+			bzs.next_out  = outbuf;
+			bzs.avail_out = TAR_DECOMP_BUFFER_SIZE;
+			ret = BZ2_bzDecompress(&bzs);
+			if ( ret != BZ_OK && ret != BZ_STREAM_END ) {
+				fprintf(stderr, "Error decompressing the archive %s (bzip2 error %d)\n", path, ret);
+				goto fail;
+			}
+			if ( feed_stream( &stream, outbuf, TAR_DECOMP_BUFFER_SIZE - bzs.avail_out ) )
+				goto fail;
+			if ( ret == BZ_STREAM_END ) {
+				BZ2_bzDecompressEnd(&bzs);
+				bzinit = 0;
+			}
+		}
+	}
+/* Flush the rest of the decompressed data */
+	while ( bzinit && ret == BZ_OK && stream.state != TAR_STATE_END ) {
+		bzs.next_out  = outbuf;
+		bzs.avail_out = TAR_DECOMP_BUFFER_SIZE;
+		ret = BZ2_bzDecompress(&bzs);
+		if ( (ret != BZ_OK && ret != BZ_STREAM_END) || bzs.avail_out == TAR_DECOMP_BUFFER_SIZE )
+			break;
+		if ( feed_stream( &stream, outbuf, TAR_DECOMP_BUFFER_SIZE - bzs.avail_out ) )
+			goto fail;
+	}
+/* */
+	if ( ferror(fd) ) {
+		fprintf(stderr, "Error reading the archive %s: %s\n", path, strerror(errno));
+		goto fail;
+	}
+	if ( stream.state != TAR_STATE_END && (stream.state != TAR_STATE_HEADER || stream.filled) )
+		fprintf(stderr, "WARNING! The archive %s is truncated, only %u members are read!\n", path, stream.archive->nmembers);
+
+/* */
+	if ( bzinit )
+		BZ2_bzDecompressEnd(&bzs);
+	if ( stream.state == TAR_STATE_DATA )
+		free(stream.buffer);
+	free(inbuf);
+	free(outbuf);
+	fclose(fd);
+
+	return stream.archive;
+
+fail:
+	if ( bzinit )
+		BZ2_bzDecompressEnd(&bzs);
+	if ( stream.state == TAR_STATE_DATA )
+		free(stream.buffer);
+	tar_archive_close( stream.archive );
+	free(inbuf);
+	free(outbuf);
+	fclose(fd);
+
+	return NULL;
+}
+
+/**
+ * @brief Find the member by its base name.
+ *
+ * @param archive
+ * @param name
+ * @return TAR_MEMBER*
+ */
+TAR_MEMBER *tar_member_find( TAR_ARCHIVE *archive, const char *name )
+{
+	TAR_MEMBER *result;
+	uint32_t    next;
+
+/* */
+	for ( next = archive->hash[hash_name( name ) % TAR_HASH_SIZE]; next; next = result->next ) {
+		result = archive->members + next - 1;
+		if ( !strcmp(result->name, name) )
+			return result;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Release the data buffer of the member after it has been loaded.
+ *
+ * @param member
+ */
+void tar_member_release( TAR_MEMBER *member )
+{
+	if ( member && member->data ) {
+		free(member->data);
+		member->data = NULL;
+		member->size = 0;
+	}
+
+	return;
+}
+
+/**
+ * @brief
+ *
+ * @param archive
+ */
+void tar_archive_close( TAR_ARCHIVE *archive )
+{
+	if ( archive ) {
+		for ( uint32_t i = 0; i < archive->nmembers; i++ ) {
+			free(archive->members[i].name);
+			free(archive->members[i].data);
+		}
+		free(archive->members);
+		free(archive);
+	}
+
+	return;
+}
+
+/**
+ * @brief Feed the chunk of tar stream into the parser.
+ *
+ * @param stream
+ * @param chunk
+ * @param size
+ * @return int
+ */
+static int feed_stream( TAR_STREAM *stream, const char *chunk, size_t size )
+{
+	size_t n;
+
+/* */
+	while ( size > 0 ) {
+		switch ( stream->state ) {
+		case TAR_STATE_HEADER:
+			n = TAR_BLOCK_SIZE - stream->filled;
+			n = n < size ? n : size;
+			memcpy(stream->header + stream->filled, chunk, n);
+			stream->filled += n;
+			if ( stream->filled == TAR_BLOCK_SIZE ) {
+				stream->filled = 0;
+				if ( parse_header( stream ) )
+					return -1;
+			}
+			break;
+		case TAR_STATE_DATA:
+			n = stream->remain < size ? stream->remain : size;
+			if ( stream->buffer )
+				memcpy(stream->buffer + stream->size - stream->remain, chunk, n);
+			if ( !(stream->remain -= n) && finish_data( stream ) )
+				return -1;
+			break;
+		case TAR_STATE_PADDING:
+			n = stream->remain < size ? stream->remain : size;
+			if ( !(stream->remain -= n) )
+				stream->state = TAR_STATE_HEADER;
+			break;
+		default:
+			return 0;
+		}
+	/* */
+		chunk += n;
+		size  -= n;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Parse the header block & get ready for its data.
+ *
+ * @param stream
+ * @return int
+ */
+static int parse_header( TAR_STREAM *stream )
+{
+	const char *hdr      = stream->header;
+	size_t      checksum = 0;
+	char        name[TAR_MAX_NAME];
+
+/* The zero block marks the end of archive */
+	for ( checksum = 0; checksum < TAR_BLOCK_SIZE && !hdr[checksum]; checksum++ );
+	if ( checksum == TAR_BLOCK_SIZE ) {
+		stream->state = TAR_STATE_END;
+		return 0;
+	}
+/* The checksum is computed with the checksum field as spaces */
+	checksum = 0;
+	for ( int i = 0; i < TAR_BLOCK_SIZE; i++ )
+		checksum += (i >= 148 && i < 156) ? ' ' : (uint8_t)hdr[i];
+	if ( checksum != parse_octal( hdr + 148, 8 ) ) {
+		fprintf(stderr, "ERROR! Broken tar header block!\n");
+		return -1;
+	}
+/* */
+	stream->size   = parse_octal( hdr + 124, 12 );
+	stream->remain = stream->size;
+	stream->buffer = NULL;
+	switch ( hdr[156] ) {
+	case '0': case '\0': case '7':
+	/* Regular file, the name might come from the previous long name or pax header */
+		if ( !stream->has_name ) {
+			if ( !memcmp(hdr + 257, "ustar", 5) && hdr[345] )
+				snprintf(name, sizeof(name), "%.155s/%.100s", hdr + 345, hdr);
+			else
+				snprintf(name, sizeof(name), "%.100s", hdr);
+			memcpy(stream->name, name, sizeof(name));
+		}
+		stream->has_name = 0;
+		stream->target = TAR_TARGET_MEMBER;
+		if ( !(stream->buffer = (char *)malloc(stream->size ? stream->size : 1)) ) {
+			fprintf(stderr, "ERROR! Out of memory for the archive member %s\n", stream->name);
+			return -1;
+		}
+		break;
+	case 'L':
+		stream->target = TAR_TARGET_LONGNAME;
+		if ( !(stream->buffer = (char *)calloc(1, stream->size + 1)) )
+			return -1;
+		break;
+	case 'x':
+		stream->target = TAR_TARGET_PAX;
+		if ( !(stream->buffer = (char *)calloc(1, stream->size + 1)) )
+			return -1;
+		break;
+	default:
+	/* The long name or pax header belongs to this skipped member, e.g. a directory */
+		stream->has_name = 0;
+		stream->target   = TAR_TARGET_SKIP;
+		break;
+	}
+/* */
+	stream->state = TAR_STATE_DATA;
+	if ( !stream->remain )
+		return finish_data( stream );
+
+	return 0;
+}
+
+/**
+ * @brief All the data of the current member has been received.
+ *
+ * @param stream
+ * @return int
+ */
+static int finish_data( TAR_STREAM *stream )
+{
+	char *path;
+
+/* */
+	switch ( stream->target ) {
+	case TAR_TARGET_MEMBER:
+	/* The buffer is taken (or freed) by the member list anyway */
+		if ( add_member( stream, stream->name ) ) {
+			stream->buffer = NULL;
+			return -1;
+		}
+		break;
+	case TAR_TARGET_LONGNAME:
+		snprintf(stream->name, sizeof(stream->name), "%s", stream->buffer);
+		stream->has_name = 1;
+		free(stream->buffer);
+		break;
+	case TAR_TARGET_PAX:
+	/* Only the path record is used, e.g. "30 path=dir/name.of.the.file\n" */
+		if ( (path = strstr(stream->buffer, " path=")) ) {
+			path += 6;
+			path[strcspn(path, "\n")] = '\0';
+			snprintf(stream->name, sizeof(stream->name), "%s", path);
+			stream->has_name = 1;
+		}
+		free(stream->buffer);
+		break;
+	default:
+		break;
+	}
+	stream->buffer = NULL;
+/* The data is padded to the block size */
+	stream->remain = (TAR_BLOCK_SIZE - stream->size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE;
+	stream->state  = stream->remain ? TAR_STATE_PADDING : TAR_STATE_HEADER;
+
+	return 0;
+}
+
+/**
+ * @brief Append the member with the received data & index it by its base name.
+ *
+ * @param stream
+ * @param path
+ * @return int
+ */
+static int add_member( TAR_STREAM *stream, const char *path )
+{
+	TAR_ARCHIVE *archive = stream->archive;
+	TAR_MEMBER  *member;
+	const char  *name;
+	uint32_t     slot;
+
+/* */
+	if ( (name = strrchr(path, '/')) )
+		name++;
+	else
+		name = path;
+/* Keep the first one when there are members of the same name */
+	if ( !*name || tar_member_find( archive, name ) ) {
+		free(stream->buffer);
+		return 0;
+	}
+/* */
+	if ( archive->nmembers >= stream->maxmembers ) {
+		stream->maxmembers = stream->maxmembers ? stream->maxmembers * 2 : 1024;
+		if ( !(member = (TAR_MEMBER *)realloc(archive->members, stream->maxmembers * sizeof(TAR_MEMBER))) ) {
+			fprintf(stderr, "ERROR! Out of memory for the archive members\n");
+			free(stream->buffer);
+			return -1;
+		}
+		archive->members = member;
+	}
+	member = archive->members + archive->nmembers;
+	if ( !(member->name = strdup(name)) ) {
+		free(stream->buffer);
+		return -1;
+	}
+	member->data = stream->buffer;
+	member->size = stream->size;
+/* */
+	slot = hash_name( name ) % TAR_HASH_SIZE;
+	member->next = archive->hash[slot];
+	archive->hash[slot] = ++archive->nmembers;
+
+	return 0;
+}
+
+/**
+ * @brief Parse the numeric field of tar header, in octal or the GNU base-256 format.
+ *
+ * @param field
+ * @param length
+ * @return size_t
+ */
+static size_t parse_octal( const char *field, const int length )
+{
+	size_t result = 0;
+	int    i      = 0;
+
+/* */
+	if ( (uint8_t)field[0] & 0x80 ) {
+		result = (uint8_t)field[0] & 0x7f;
+		for ( i = 1; i < length; i++ )
+			result = (result << 8) | (uint8_t)field[i];
+		return result;
+	}
+/* */
+	for ( ; i < length && (field[i] == ' ' || field[i] == '0'); i++ );
+	for ( ; i < length && field[i] >= '0' && field[i] <= '7'; i++ )
+		result = (result << 3) | (size_t)(field[i] - '0');
+
+	return result;
+}
+
+/**
+ * @brief
+ *
+ * @param name
+ * @return uint32_t
+ */
+static uint32_t hash_name( const char *name )
+{
+	register uint32_t result = 2166136261u;
+
+/* */
+	for ( ; *name; name++ ) {
+		result ^= (uint8_t)*name;
+		result *= 16777619u;
+	}
+
+	return result;
+}
@@ -0,0 +1,233 @@
+/**
+ * @file trace_cache.c
+ * @author Benjamin Yang @ National Taiwan University (b98204032@gmail.com)
+ * @brief Keep the picked P arrival & the processed acceleration, velocity & displacement traces of
+ *        each station on disk. The cache is keyed by the identity of the station's input files & the
+ *        parameters of signal processing, so a rerun only with different thresholds or output
+ *        switches can skip the loading, picking, integration & filtering.
+ * @version 1.0.0
+ * @date 2026-10-19
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+/* */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+/* */
+#include <postmajor.h>
+#include <trace_cache.h>
+
+/* */
+#define MAX_FILE_NAME  512
+/* */
+static int      build_station_key( char *, const char *, const char *, const SNL_INFO * );
+static uint64_t hash_key( const char * );
+
+/**
+ * @brief Build the key of the signal processing parameters & the loading mode, the input files of each
+ *        station are identified later, when its cache is loaded or stored.
+ *
+ * @param key
+ * @param format
+ * @param otime
+ * @param two_stage
+ * @param ms_index
+ * @param window_start
+ * @param window_end
+ * @return int
+ */
+int trace_cache_key_build(
+	char *key, const char *format, const double otime, const _Bool two_stage,
+	const _Bool ms_index, const int64_t window_start, const int64_t window_end
+) {
+/* The index mode only loads the records within the window, so the demeaning differs */
+	if (
+		snprintf(
+			key, TRACE_CACHE_KEY_LEN, "%s|%.6f|%d|%d|%lld:%lld",
+			format, otime, two_stage ? 2 : 1, ms_index, (long long)window_start, (long long)window_end
+		) >= TRACE_CACHE_KEY_LEN
+	) {
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief Load the cached traces of the station, the buffers of traces will be allocated here.
+ *
+ * @param dir
+ * @param key
+ * @param identity
+ * @param snl_info
+ * @param traces
+ * @return int
+ */
+int trace_cache_load( const char *dir, const char *key, const char *identity, SNL_INFO *snl_info, float *traces[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] )
+{
+	char               stakey[TRACE_CACHE_KEY_LEN];
+	char               path[MAX_FILE_NAME];
+	FILE              *fp = NULL;
+	TRACE_CACHE_HEADER header;
+
+/* */
+	if ( build_station_key( stakey, key, identity, snl_info ) < 0 )
+		return -1;
+	snprintf(path, sizeof(path), TRACE_CACHE_FILE_NAME_FORMAT, dir, snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, (unsigned long long)hash_key( stakey ));
+	if ( !(fp = fopen(path, "rb")) )
+		return -1;
+/* */
+	if (
+		fread(&header, sizeof(header), 1, fp) != 1 ||
+		memcmp(header.magic, TRACE_CACHE_MAGIC, sizeof(header.magic)) || header.version != TRACE_CACHE_VERSION ||
+		strncmp(header.key, stakey, TRACE_CACHE_KEY_LEN) || header.npts <= 0
+	) {
+		fclose(fp);
+		return -1;
+	}
+/* */
+	for ( register int i = 0; i < TRACE_CACHE_NUM_STAGES; i++ ) {
+		for ( register int j = 0; j < NUM_CHANNEL_SNL; j++ ) {
+			if (
+				!(traces[i][j] = (float *)malloc(header.npts * sizeof(float))) ||
+				fread(traces[i][j], sizeof(float), header.npts, fp) != (size_t)header.npts
+			) {
+				fprintf(stderr, "WARNING! The cache %s is incomplete, skip it!\n", path);
+				trace_cache_free( traces );
+				fclose(fp);
+				return -1;
+			}
+		}
+	}
+	fclose(fp);
+/* */
+	snl_info->state->npts         = header.npts;
+	snl_info->state->starttime    = header.starttime;
+	snl_info->state->delta        = header.delta;
+	snl_info->result->snr         = header.snr;
+	snl_info->result->pick_flag   = header.pick_flag;
+	snl_info->state->parrival_pos = header.parrival_pos;
+
+	return 0;
+}
+
+/**
+ * @brief Store the traces of the station into the cache, the file is written to a temporary name & then renamed.
+ *
+ * @param dir
+ * @param key
+ * @param identity
+ * @param snl_info
+ * @param traces
+ * @return int
+ */
+int trace_cache_store( const char *dir, const char *key, const char *identity, const SNL_INFO *snl_info, float * const traces[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] )
+{
+	char               path[MAX_FILE_NAME];
+	char               tmppath[MAX_FILE_NAME + 32];
+	FILE              *fp = NULL;
+	TRACE_CACHE_HEADER header;
+
+/* */
+	for ( register int i = 0; i < TRACE_CACHE_NUM_STAGES; i++ )
+		for ( register int j = 0; j < NUM_CHANNEL_SNL; j++ )
+			if ( !traces[i][j] )
+				return -1;
+/* */
+	memset(&header, 0, sizeof(header));
+	if ( build_station_key( header.key, key, identity, snl_info ) < 0 )
+		return -1;
+	memcpy(header.magic, TRACE_CACHE_MAGIC, sizeof(header.magic));
+	header.version      = TRACE_CACHE_VERSION;
+	header.npts         = snl_info->state->npts;
+	header.starttime    = snl_info->state->starttime;
+	header.delta        = snl_info->state->delta;
+	header.snr          = snl_info->result->snr;
+	header.pick_flag    = snl_info->result->pick_flag;
+	header.parrival_pos = snl_info->state->parrival_pos;
+/* */
+	snprintf(path, sizeof(path), TRACE_CACHE_FILE_NAME_FORMAT, dir, snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc, (unsigned long long)hash_key( header.key ));
+	snprintf(tmppath, sizeof(tmppath), "%s.%ld.tmp", path, (long)getpid());
+	if ( !(fp = fopen(tmppath, "wb")) ) {
+		fprintf(stderr, "WARNING! Cannot create the cache %s, skip it!\n", tmppath);
+		return -1;
+	}
+/* */
+	_Bool failed = fwrite(&header, sizeof(header), 1, fp) != 1;
+	for ( register int i = 0; i < TRACE_CACHE_NUM_STAGES && !failed; i++ )
+		for ( register int j = 0; j < NUM_CHANNEL_SNL && !failed; j++ )
+			failed = fwrite(traces[i][j], sizeof(float), snl_info->state->npts, fp) != (size_t)snl_info->state->npts;
+	if ( fclose(fp) || failed || rename(tmppath, path) ) {
+		fprintf(stderr, "WARNING! Cannot write the cache %s, skip it!\n", path);
+		remove(tmppath);
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief
+ *
+ * @param traces
+ */
+void trace_cache_free( float *traces[TRACE_CACHE_NUM_STAGES][NUM_CHANNEL_SNL] )
+{
+	for ( register int i = 0; i < TRACE_CACHE_NUM_STAGES; i++ ) {
+		for ( register int j = 0; j < NUM_CHANNEL_SNL; j++ ) {
+			if ( traces[i][j] ) {
+				free(traces[i][j]);
+				traces[i][j] = NULL;
+			}
+		}
+	}
+
+	return;
+}
+
+/**
+ * @brief Append the station, channels & gains, they are all used by the preprocessing, & the identity of
+ *        the station's input files to the key.
+ *
+ * @param stakey
+ * @param key
+ * @param identity
+ * @param snl_info
+ * @return int
+ */
+static int build_station_key( char *stakey, const char *key, const char *identity, const SNL_INFO *snl_info )
+{
+	int len = snprintf(stakey, TRACE_CACHE_KEY_LEN, "%s|%s.%s.%s", key, snl_info->meta->sta, snl_info->meta->net, snl_info->meta->loc);
+
+/* */
+	for ( register int i = 0; i < NUM_CHANNEL_SNL && len < TRACE_CACHE_KEY_LEN; i++ )
+		len += snprintf(stakey + len, TRACE_CACHE_KEY_LEN - len, "|%s:%.9g", snl_info->meta->chan[i], snl_info->meta->gain[i]);
+	if ( len < TRACE_CACHE_KEY_LEN )
+		len += snprintf(stakey + len, TRACE_CACHE_KEY_LEN - len, "%s", identity);
+
+	return len < TRACE_CACHE_KEY_LEN ? 0 : -1;
+}
+
+/**
+ * @brief FNV-1a hash of the key.
+ *
+ * @param key
+ * @return uint64_t
+ */
+static uint64_t hash_key( const char *key )
+{
+	uint64_t result = 14695981039346656037ULL;
+
+/* */
+	for ( ; *key; key++ ) {
+		result ^= (uint8_t)*key;
+		result *= 1099511628211ULL;
+	}
+
+	return result;
+}